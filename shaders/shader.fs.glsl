@@ -4,11 +4,18 @@
 // uniform vec3 lightPos;
 uniform vec3 camPos;
 
+// Visualization: 0 = vertex color, 1 = normals, 2 = scalar through colormap
+uniform int visMode;
+uniform float scalarRange;
+uniform sampler1D colormap;
+
 // In
 struct VertexData {
     vec3 position;
     vec3 normal;
     vec3 color;
+    float selected;
+    float scalar;
 };
 in VertexData vertexData;
 // Out
@@ -19,6 +26,16 @@ void main()
     vec3 lightPos = vec3(1.0, 0.0, 0.0);
     vec3 color = vertexData.color;
 
+    // Selected triangles keep their selection color in every mode
+    bool selected = vertexData.selected > 0.5;
+    if (visMode == 1 && !selected) {
+        color = clamp(vertexData.normal, 0.0, 1.0);
+    }
+    else if (visMode == 2 && !selected) {
+        float t = clamp(vertexData.scalar / scalarRange, -1.0, 1.0) * 0.5 + 0.5;
+        color = texture(colormap, t).rgb;
+    }
+
     FragColor = vec4(color, 1.0);
     return;
 
@@ -3,26 +3,46 @@
 // Input
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normal;
-layout(location = 2) in vec3 color;
+layout(location = 2) in vec4 color; // rgb, a = selected (the point cloud only has rgb, it always draws in mode 0)
+layout(location = 3) in float scalar;
+layout(location = 4) in vec3 bindPosition;
+layout(location = 5) in ivec4 handleIndex;
+layout(location = 6) in vec4 handleWeight;
 
 // Uniform
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+// Linear blend skinning preview: bind pose plus the weighted offsets of the handles
+uniform bool skinning;
+uniform samplerBuffer handleOffsets;
+
 struct VertexData {
     vec3 position;
     vec3 normal;
     vec3 color;
+    float selected;
+    float scalar;
 };
 
 out VertexData vertexData;
 
 void main()
 {
-    vertexData.position = position;
+    vec3 pos = position;
+    if (skinning) {
+        pos = bindPosition;
+        for (int i = 0; i < 4; ++i) {
+            pos += handleWeight[i] * texelFetch(handleOffsets, handleIndex[i]).xyz;
+        }
+    }
+
+    vertexData.position = pos;
     vertexData.normal = normal;
-    vertexData.color = color;
+    vertexData.color = color.rgb;
+    vertexData.selected = color.a;
+    vertexData.scalar = scalar;
 
-    gl_Position = projection * view * model * vec4(position, 1.0);
+    gl_Position = projection * view * model * vec4(pos, 1.0);
 }
@@ -1,12 +1,64 @@
 #include "Engine.hpp"
+#include "Utilities/TaskScheduler.hpp"
+#include "Utilities/GpuProfiler.hpp"
+#include "Utilities/Logger.hpp"
+#include "GenAPI/json.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
 #include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+    nlohmann::json summarizeFrameTimes(std::vector<double> samples) {
+        nlohmann::json result;
+        if (samples.empty()) return result;
+
+        std::sort(samples.begin(), samples.end());
+        double mean = 0.0;
+        for (double sample : samples) mean += sample;
+        mean /= samples.size();
+
+        double variance = 0.0;
+        for (double sample : samples) variance += (sample - mean) * (sample - mean);
+        variance /= std::max<size_t>(1, samples.size() - 1);
+
+        auto percentile = [&samples](double p) {
+            return samples[std::min(samples.size() - 1, static_cast<size_t>(p * samples.size()))];
+        };
+
+        result["mean_ms"] = mean;
+        result["median_ms"] = percentile(0.5);
+        result["p95_ms"] = percentile(0.95);
+        result["p99_ms"] = percentile(0.99);
+        result["min_ms"] = samples.front();
+        result["max_ms"] = samples.back();
+        result["stddev_ms"] = std::sqrt(variance);
+        return result;
+    }
+}
 
 Engine* Engine::instance = nullptr;
 
-Engine::Engine() : m_renderer(), m_trackball(), m_isDraggingAxis(false)
+Engine::Engine(const OffscreenOptions& offscreen, const SessionOptions& session)
+    : m_renderer(), m_trackball(), m_isDraggingAxis(false),
+      m_offscreen(offscreen), m_offscreenFBO(0), m_offscreenColor(0), m_offscreenDepth(0), m_offscreenReady(false),
+      m_session(session), m_frameActions(0), m_cursorX(0.0), m_cursorY(0.0), m_redrawFrames(0), m_wakeRequested(false)
 {
     instance = this;
+    Profiler::setThreadName("render");
+
+    if (m_offscreen.enabled) {
+        m_screenWidth = m_offscreen.width;
+        m_screenHeight = m_offscreen.height;
+    }
+    else if (!m_session.replayPath.empty() && m_player.load(m_session.replayPath)) {
+        m_screenWidth = m_player.getWidth(); // Same layout and picking rays as when it was recorded
+        m_screenHeight = m_player.getHeight();
+    }
 
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -15,12 +67,16 @@ Engine::Engine() : m_renderer(), m_trackball(), m_isDraggingAxis(false)
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
+    if (m_offscreen.enabled) {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    }
 
     m_window = glfwCreateWindow(m_screenWidth, m_screenHeight, "Geometric Modeling", NULL, NULL);
     if (m_window == NULL)
     {
-        std::cout << "Failed to create GLFW window" << std::endl;
+        LOG_ERROR("Failed to create GLFW window");
         glfwTerminate();
+        Logger::flush();
         std::terminate(); // TODO: Change handle error
     }
 
@@ -30,19 +86,46 @@ Engine::Engine() : m_renderer(), m_trackball(), m_isDraggingAxis(false)
     glfwSetWindowSizeCallback(m_window, resizeCallback);
     glfwSetCursorPosCallback(m_window, cursorPosCallback);
     glfwSetMouseButtonCallback(m_window, mouseButtonCallback);
+    glfwSetKeyCallback(m_window, keyCallback);       // Set before ImGui so its handlers chain to these
+    glfwSetCharCallback(m_window, charCallback);
+    glfwSetWindowRefreshCallback(m_window, refreshCallback);
+    glfwSetWindowFocusCallback(m_window, focusCallback);
+    glfwSetCursorEnterCallback(m_window, cursorEnterCallback);
 
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
     {
-        std::cout << "Failed to initialize GLAD" << std::endl;
+        LOG_ERROR("Failed to initialize GLAD");
+        Logger::flush();
         std::terminate(); // TODO: Change handle error
     }
 
+    if (m_offscreen.enabled) {
+        m_offscreenReady = createOffscreenTarget();
+    }
+
     m_renderer = new Renderer();
     m_trackball = new Trackball(m_screenWidth, m_screenHeight);
     m_interface = new Interface(m_window, m_screenWidth, m_screenHeight);
     
     // Set mesh data reference in interface
     m_interface->setMeshData(m_renderer->getMeshData());
+    m_interface->setMemoryReportSource([this]() { return m_renderer->collectMemoryUsage(); });
+
+    // Workers wake the event wait when their result is ready to be picked up
+    TaskScheduler::instance().setMainThreadWakeCallback([this]() { wake(); });
+    m_interface->setWakeCallback([this]() { wake(); });
+    m_renderer->getMeshData()->setWorkFinishedCallback([this]() { wake(); });
+
+    if (!m_session.replayPath.empty() || !m_session.recordPath.empty()) {
+        m_interface->setLayoutPersistence(false);
+    }
+    if (!m_session.recordPath.empty() && m_recorder.open(m_session.recordPath, m_screenWidth, m_screenHeight)) {
+        // GLFW only reports changes, so start the log with the state the first frame sees
+        glfwGetCursorPos(m_window, &m_cursorX, &m_cursorY);
+        m_recorder.focus(glfwGetWindowAttrib(m_window, GLFW_FOCUSED));
+        m_recorder.cursorEnter(glfwGetWindowAttrib(m_window, GLFW_HOVERED));
+        m_recorder.cursorPos(m_cursorX, m_cursorY);
+    }
 }
 
 Engine::~Engine()
@@ -53,18 +136,23 @@ Engine::~Engine()
 
 void Engine::resizeCallback(GLFWwindow* window, int width, int height)
 {
+    instance->m_recorder.resize(width, height);
     instance->m_screenWidth = width;
     instance->m_screenHeight = height;
     glViewport(0, 0, width, height);
 
     instance->m_interface->resize(width, height);
     instance->m_trackball->resize(width, height);
+    instance->requestRedraw();
 }
 
 void Engine::mouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
 {
-    double xpos, ypos;
-    glfwGetCursorPos(window, &xpos, &ypos);
+    instance->m_recorder.mouseButton(button, action, mods);
+    instance->requestRedraw();
+
+    const double xpos = instance->m_cursorX;
+    const double ypos = instance->m_cursorY;
     if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
     {
         if(!instance->m_interface->isHovered())
@@ -121,40 +209,131 @@ void Engine::mouseButtonCallback(GLFWwindow* window, int button, int action, int
 
 void Engine::cursorPosCallback(GLFWwindow* window, double xpos, double ypos)
 {
+    instance->m_recorder.cursorPos(xpos, ypos);
+    instance->m_cursorX = xpos;
+    instance->m_cursorY = ypos;
     instance->m_trackball->drag(xpos, ypos);
+    instance->requestRedraw();
 }
 
 void Engine::scrollCallback(GLFWwindow* window, double xoffset, double yoffset)
 {
+    instance->m_recorder.scroll(xoffset, yoffset);
     instance->m_trackball->zoom(yoffset);
+    instance->requestRedraw();
+}
+
+void Engine::keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    instance->m_recorder.key(key, scancode, action, mods);
+    instance->requestRedraw();
+}
+
+void Engine::charCallback(GLFWwindow* window, unsigned int codepoint)
+{
+    instance->m_recorder.character(codepoint);
+    instance->requestRedraw();
+}
+
+void Engine::refreshCallback(GLFWwindow* window)
+{
+    instance->requestRedraw(1);
+}
+
+void Engine::focusCallback(GLFWwindow* window, int focused)
+{
+    instance->m_recorder.focus(focused);
+    instance->requestRedraw();
+}
+
+void Engine::cursorEnterCallback(GLFWwindow* window, int entered)
+{
+    instance->m_recorder.cursorEnter(entered);
+    instance->requestRedraw();
+}
+
+void Engine::requestRedraw(int frames)
+{
+    m_redrawFrames = std::max(m_redrawFrames, frames);
+}
+
+void Engine::wake()
+{
+    // The empty event carries no information, the flag tells the idle loop it was a real wake
+    m_wakeRequested = true;
+    glfwPostEmptyEvent();
 }
 
 void Engine::update() {
+    PROFILE_SCOPE("Engine::update");
+
     static int lastMode = 1;
 
     lastMode = m_interface->getVisualizeMode() != 0 ? m_interface->getVisualizeMode() : lastMode;
 
     MeshData* meshData = m_renderer->getMeshData();
+
+    // Swap in finished solves and bakes before anything reads the vertices this frame
+    if (meshData->consumePublishedAnimation()) {
+        meshData->refreshPosition(m_interface->getTimeFrame());
+    }
+    meshData->consumeSolverResults(m_interface->getTimeFrame());
+    meshData->setSkinningPreview(m_interface->getDeformer() == Interface::Skinning);
+    meshData->consumeSkinningWeights(); // The pose is shown once the upload lands on the main thread
+
+    // Mode and range are uniforms, buffers are only uploaded when one of their inputs changed
+    const float range = m_interface->getWeight();
     if(m_interface->getVisualizeMode() == 1) {
-        meshData->refreshTriangleColor(MeshVisMode::None);
+        meshData->updateTriangleColor(MeshVisMode::None, range);
     }
     else if(m_interface->getVisualizeMode() == 2) {
-        meshData->refreshTriangleColor(MeshVisMode::Normals);
+        meshData->updateTriangleColor(MeshVisMode::Normals, range);
     }
     else if(m_interface->getVisualizeMode() == 3) {
-        meshData->refreshTriangleColor(MeshVisMode::Weight);
+        meshData->updateTriangleColor(MeshVisMode::Weight, range);
+    }
+
+    m_frameActions = 0;
+
+    // Both only queue work on the solver thread
+    if (m_interface->getCompute() && m_interface->getDeformer() == Interface::Laplacian) {
+        m_frameActions |= SessionActionCompute;
+        meshData->computeLaplacianSurfaceModeling();
+    }
+    else if (m_interface->getCompute() && m_interface->getDeformer() == Interface::Skinning) {
+        m_frameActions |= SessionActionCompute;
+        meshData->computeSkinningWeights();
     }
+    else if (m_interface->getCompute()) {
+        m_frameActions |= SessionActionCompute;
+        ArapSettings settings;
+        settings.maxIterations = m_interface->getArapMaxIterations();
+        settings.tolerance = m_interface->getArapTolerance();
+        settings.timeBudgetMs = m_interface->getArapTimeBudgetMs();
+        settings.hierarchical = m_interface->getArapMultilevel();
+        settings.fineIterations = m_interface->getArapFineIterations();
+        meshData->setArapSettings(settings);
 
-    if (m_interface->getCompute()) {
+        RoiOptions roi;
+        roi.enabled = m_interface->getRoiEnabled();
+        roi.source = m_interface->getRoiFromSelection() ? RoiSource::SelectedTriangles : RoiSource::Radius;
+        roi.radius = m_interface->getRoiRadius();
+        meshData->setRoiOptions(roi);
         meshData->computeARAP();
-        // meshData->computeLaplacianSurfaceModeling();
+    }
+
+    if (m_interface->getSolveAllFrames()) {
+        m_frameActions |= SessionActionSolveAll;
+        std::vector<float> times;
+        for (int t = 0; t <= 10; ++t) {
+            times.push_back(static_cast<float>(t));
+        }
+        meshData->solveKeyframes(times);
     }
 
     if(instance->m_isDraggingAxis == true) {
         // Axis Logic Update
-        double xpos, ypos;
-        glfwGetCursorPos(m_window, &xpos, &ypos);
-        Eigen::Vector3f screenCoord(static_cast<float>(xpos), static_cast<float>(ypos), 0);
+        Eigen::Vector3f screenCoord(static_cast<float>(m_cursorX), static_cast<float>(m_cursorY), 0);
         Eigen::Vector3f nearCoord = instance->m_trackball->unProject(screenCoord);
         Gizmo* gizmo = instance->m_renderer->getGizmo();
         gizmo->dragAlongAxis(m_trackball->getPosition(), nearCoord);
@@ -163,16 +342,29 @@ void Engine::update() {
         int idx = meshData->getLastSelectedVertex();
         if(idx != -1) {
             meshData->changeVertexPosition(idx, t);
+
+            // A back-substitution per drag step, waiting ones are replaced by the newest.
+            // Skinning only uploads the handle offsets
+            if (m_interface->getLivePreview()) {
+                meshData->computeLaplacianSurfaceModeling();
+            }
+            else if (m_interface->getDeformer() == Interface::Skinning) {
+                meshData->previewSkinnedPose();
+            }
         }
     }
 
     if(instance->m_interface->getDoRefresh()) {
+        m_frameActions |= SessionActionRefresh;
         Gizmo* gizmo = instance->m_renderer->getGizmo();
         gizmo->clearSelection();
-        meshData->refreshPosition(m_interface->getTimeFrame());
+        if (!meshData->previewSkinnedPose(m_interface->getTimeFrame())) {
+            meshData->refreshPosition(m_interface->getTimeFrame());
+        }
     }
 
     if(m_interface->getSetTimeFrame()) {
+        m_frameActions |= SessionActionSaveTimeframe;
         meshData->saveTimeFrame(m_interface->getTimeFrame());
     }
 
@@ -187,7 +379,7 @@ void Engine::update() {
     }
 }
 
-void Engine::run()
+int Engine::run()
 {
     glClearColor(0.5f, 0.5f, 1.0f, 1.0f);
     glEnable(GL_DEPTH_TEST);
@@ -196,26 +388,392 @@ void Engine::run()
     glEnable(GL_POLYGON_OFFSET_FILL);
     glPolygonOffset(1.0f, 1.0f);
 
+    if (!m_session.tracePath.empty()) {
+        Profiler::startTrace();
+    }
+
+    int result = 0;
+    if (m_offscreen.enabled) {
+        result = runOffscreen();
+    }
+    else if (!m_session.replayPath.empty()) {
+        result = runReplay();
+    }
+    else {
+        runInteractive();
+    }
+
+    if (!m_session.tracePath.empty()) {
+        Profiler::stopTrace();
+        Profiler::writeChromeTrace(m_session.tracePath);
+    }
+    m_recorder.close();
+
+    glfwTerminate();
+    return result;
+}
+
+void Engine::runInteractive()
+{
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point lastFrame = Clock::now();
+    requestRedraw();
+
     while (!glfwWindowShouldClose(m_window))
     {
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        const bool idle = m_interface->isIdleMode();
+        const bool animating = m_interface->isAnimating();
+
+        if (!idle || m_redrawFrames > 0) {
+            glfwPollEvents();
+        }
+        else if (animating) {
+            // Frame budget governor, sleep off what is left of the budget while still reacting to input
+            const double budget = 1.0 / std::max(1, m_interface->getPlaybackFps());
+            const double spent = std::chrono::duration<double>(Clock::now() - lastFrame).count();
+            if (spent < budget) {
+                glfwWaitEventsTimeout(budget - spent);
+            } else {
+                glfwPollEvents();
+            }
+            requestRedraw(1);
+        }
+        else if (m_interface->hasBackgroundWork()) {
+            // Progress bars and the Solving... state only change on screen if they are redrawn
+            glfwWaitEventsTimeout(0.1);
+            requestRedraw(1);
+        }
+        else {
+            // Nothing runs, only input (its callbacks ask for a redraw) or a wake can change the picture
+            glfwWaitEvents();
+        }
+        if (m_wakeRequested.exchange(false)) {
+            requestRedraw(1);
+        }
+
+        if (idle && m_redrawFrames == 0) {
+            continue;
+        }
+
+        const Clock::time_point frameStart = Clock::now();
+        Profiler::collectGpuTimings(); // Queries issued a few frames ago
+        {
+            PROFILE_SCOPE("Frame");
 
-        // Update
-        update();
+            const float elapsed = std::min(std::chrono::duration<float>(frameStart - lastFrame).count(), 0.25f); // Don't jump after a long idle wait
+            lastFrame = frameStart;
 
-        // Draw
-        const CameraParam cameraParam(
-            m_trackball->getProjectionMatrix(),
-            m_trackball->getViewMatrix(),
-            m_trackball->getPosition()
-        );
-        m_renderer->draw(cameraParam);
-        m_interface->draw();
+            m_recorder.frame(glfwGetTime(), elapsed);
+            drawFrame(elapsed);
+            m_recorder.actions(m_frameActions);
+        }
 
+        m_interface->setFrameTime(std::chrono::duration<float, std::milli>(Clock::now() - frameStart).count());
+        if (m_redrawFrames > 0) {
+            m_redrawFrames--;
+        }
+    }
+}
+
+void Engine::drawFrame(float elapsed)
+{
+    m_interface->advancePlayback(elapsed);
+
+    // Continuations of background tasks that have to touch GL or UI state
+    {
+        PROFILE_SCOPE("Main thread tasks");
+        TaskScheduler::instance().pumpMainThread();
+    }
+
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // Update
+    update();
+
+    // Draw
+    const CameraParam cameraParam(
+        m_trackball->getProjectionMatrix(),
+        m_trackball->getViewMatrix(),
+        m_trackball->getPosition()
+    );
+    m_renderer->draw(cameraParam);
+    m_interface->draw();
+
+    {
+        PROFILE_SCOPE("Swap buffers");
         glfwSwapBuffers(m_window);
+    }
+}
+
+// Session replay =====================================================================================
+void Engine::dispatchReplayEvent(const SessionEvent& event)
+{
+    // ImGui first, as with live input, then the Engine handler for the same event
+    m_interface->replayEvent(event);
+
+    switch (event.type) {
+        case SessionEventType::CursorPos:   cursorPosCallback(m_window, event.x, event.y); break;
+        case SessionEventType::MouseButton: mouseButtonCallback(m_window, event.a, event.action, event.mods); break;
+        case SessionEventType::Scroll:      scrollCallback(m_window, event.x, event.y); break;
+        case SessionEventType::Key:         keyCallback(m_window, event.a, event.b, event.action, event.mods); break;
+        case SessionEventType::Char:        charCallback(m_window, static_cast<unsigned int>(event.a)); break;
+        case SessionEventType::Focus:       focusCallback(m_window, event.a); break;
+        case SessionEventType::CursorEnter: cursorEnterCallback(m_window, event.a); break;
+        case SessionEventType::Resize:
+            glfwSetWindowSize(m_window, event.a, event.b);
+            resizeCallback(m_window, event.a, event.b);
+            break;
+        default:
+            break;
+    }
+}
+
+int Engine::runReplay()
+{
+    typedef std::chrono::steady_clock Clock;
+
+    const std::vector<SessionFrame>& frames = m_player.getFrames();
+    if (frames.empty()) {
+        return 1;
+    }
+
+    // Live input must not mix with the recording, only window events are still polled
+    m_interface->detachInputCallbacks();
+    glfwSetCursorPosCallback(m_window, nullptr);
+    glfwSetMouseButtonCallback(m_window, nullptr);
+    glfwSetScrollCallback(m_window, nullptr);
+    glfwSetKeyCallback(m_window, nullptr);
+    glfwSetCharCallback(m_window, nullptr);
+    glfwSetWindowSizeCallback(m_window, nullptr);
+    glfwSetWindowFocusCallback(m_window, nullptr);
+    glfwSetCursorEnterCallback(m_window, nullptr);
+
+    std::vector<double> frameMs;
+    frameMs.reserve(frames.size());
+    size_t diverged = 0;
+    long firstDivergence = -1;
+
+    const Clock::time_point start = Clock::now();
+    const double recordedStart = frames.front().time;
+
+    size_t frame = 0;
+    for (; frame < frames.size() && !glfwWindowShouldClose(m_window); ++frame) {
+        const SessionFrame& recorded = frames[frame];
         glfwPollEvents();
+
+        if (m_session.replaySync) {
+            // Solves, bakes and requests land on whichever frame they finish on. Waiting for them here
+            // makes every replay pick the results up on the same frame, at the cost of the wait
+            while (m_interface->hasBackgroundWork()) {
+                TaskScheduler::instance().pumpMainThread();
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+
+        if (!m_session.replayFast) {
+            const double due = recorded.time - recordedStart;
+            const double now = std::chrono::duration<double>(Clock::now() - start).count();
+            if (due > now) {
+                std::this_thread::sleep_for(std::chrono::duration<double>(due - now));
+            }
+        }
+
+        glfwSetTime(recorded.time); // ImGui takes its delta time and double clicks from this clock
+        for (const SessionEvent& event : recorded.events) {
+            dispatchReplayEvent(event);
+        }
+
+        const Clock::time_point frameStart = Clock::now();
+        Profiler::collectGpuTimings();
+        {
+            PROFILE_SCOPE("Frame");
+            drawFrame(recorded.delta);
+        }
+        const double ms = std::chrono::duration<double, std::milli>(Clock::now() - frameStart).count();
+        frameMs.push_back(ms);
+        m_interface->setFrameTime(static_cast<float>(ms));
+
+        if (m_frameActions != recorded.actions) {
+            if (firstDivergence < 0) firstDivergence = static_cast<long>(frame);
+            diverged++;
+        }
     }
 
-    glfwTerminate();
-    return;
+    const nlohmann::json summary = summarizeFrameTimes(frameMs);
+    LOG_INFO("Replayed " << frame << " of " << frames.size() << " frames in "
+             << std::chrono::duration<double>(Clock::now() - start).count() << " s");
+    if (!frameMs.empty()) {
+        LOG_INFO("Frame ms: mean " << summary["mean_ms"].get<double>()
+                 << ", median " << summary["median_ms"].get<double>()
+                 << ", p95 " << summary["p95_ms"].get<double>()
+                 << ", max " << summary["max_ms"].get<double>());
+    }
+    if (diverged > 0) {
+        LOG_WARN("Replay diverged on " << diverged << " frames, first at frame " << firstDivergence);
+        return 1;
+    }
+    return 0;
+}
+
+// Offscreen ==========================================================================================
+bool Engine::createOffscreenTarget()
+{
+    glGenRenderbuffers(1, &m_offscreenColor);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_offscreenColor);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_screenWidth, m_screenHeight);
+
+    glGenRenderbuffers(1, &m_offscreenDepth);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_offscreenDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_screenWidth, m_screenHeight);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &m_offscreenFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_offscreenFBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_offscreenColor);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_offscreenDepth);
+    const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        LOG_ERROR("Offscreen framebuffer is incomplete, status 0x" << std::hex << status << std::dec);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &m_offscreenFBO);
+        glDeleteRenderbuffers(1, &m_offscreenColor);
+        glDeleteRenderbuffers(1, &m_offscreenDepth);
+        m_offscreenFBO = m_offscreenColor = m_offscreenDepth = 0;
+        return false;
+    }
+
+    glViewport(0, 0, m_screenWidth, m_screenHeight);
+    return true;
+}
+
+void Engine::applyCameraPath(int frame, int frameCount)
+{
+    // One full turn and/or one zoom in and out over the run, the same path every time
+    const float t = static_cast<float>(frame) / std::max(1, frameCount);
+    const float twoPi = 2.0f * static_cast<float>(M_PI);
+
+    const bool orbit = m_offscreen.cameraPath == "orbit" || m_offscreen.cameraPath == "orbit-zoom";
+    const bool zoom = m_offscreen.cameraPath == "zoom" || m_offscreen.cameraPath == "orbit-zoom";
+
+    const float phi = orbit ? twoPi * t : 0.0f;
+    const float theta = static_cast<float>(M_PI) / 2.0f - (orbit ? 0.3f * std::sin(twoPi * t) : 0.0f);
+    const float radius = zoom ? 5.0f - 3.0f * std::sin(0.5f * twoPi * t) : 5.0f;
+    m_trackball->setOrbit(phi, theta, radius);
+}
+
+int Engine::runOffscreen()
+{
+    typedef std::chrono::steady_clock Clock;
+
+    if (!m_offscreenReady) {
+        LOG_ERROR("Offscreen run aborted, no render target");
+        return 1;
+    }
+
+    const int warmup = std::max(0, m_offscreen.warmupFrames);
+    const int frames = std::max(1, m_offscreen.frames);
+    MeshData* meshData = m_renderer->getMeshData();
+
+    const char* glRenderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+    const char* glVersion = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    LOG_INFO("Offscreen run: " << frames << " frames at " << m_screenWidth << "x" << m_screenHeight
+             << ", camera " << m_offscreen.cameraPath << ", " << (glRenderer ? glRenderer : "unknown renderer"));
+
+    std::vector<double> cpuMs, frameMs;
+    cpuMs.reserve(frames);
+    frameMs.reserve(frames);
+
+    Profiler::setEnabled(true);
+    for (int frame = 0; frame < warmup + frames; ++frame) {
+        if (frame == warmup) {
+            Profiler::reset(); // Scope statistics only cover the measured frames
+        }
+
+        glfwPollEvents();
+        applyCameraPath(frame, warmup + frames);
+
+        const Clock::time_point frameStart = Clock::now();
+        Profiler::collectGpuTimings();
+        {
+            PROFILE_SCOPE("Frame");
+            TaskScheduler::instance().pumpMainThread();
+
+            glBindFramebuffer(GL_FRAMEBUFFER, m_offscreenFBO);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            update();
+            if (m_offscreen.poseUpdates) {
+                meshData->refreshPosition();
+            }
+
+            const CameraParam cameraParam(
+                m_trackball->getProjectionMatrix(),
+                m_trackball->getViewMatrix(),
+                m_trackball->getPosition()
+            );
+            m_renderer->draw(cameraParam);
+            if (m_offscreen.drawInterface) {
+                m_interface->draw();
+            }
+        }
+        const Clock::time_point submitted = Clock::now();
+
+        // Nothing is presented, so wait for the GPU here or the frame time would only be the submission
+        glFinish();
+        const Clock::time_point finished = Clock::now();
+
+        if (frame >= warmup) {
+            cpuMs.push_back(std::chrono::duration<double, std::milli>(submitted - frameStart).count());
+            frameMs.push_back(std::chrono::duration<double, std::milli>(finished - frameStart).count());
+        }
+    }
+    Profiler::collectGpuTimings();
+    Profiler::setEnabled(false);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &m_offscreenFBO);
+    glDeleteRenderbuffers(1, &m_offscreenColor);
+    glDeleteRenderbuffers(1, &m_offscreenDepth);
+
+    nlohmann::json report;
+    report["renderer"] = glRenderer ? glRenderer : "";
+    report["gl_version"] = glVersion ? glVersion : "";
+    report["width"] = m_screenWidth;
+    report["height"] = m_screenHeight;
+    report["frames"] = frames;
+    report["warmup_frames"] = warmup;
+    report["camera_path"] = m_offscreen.cameraPath;
+    report["interface"] = m_offscreen.drawInterface;
+    report["pose_updates"] = m_offscreen.poseUpdates;
+    report["vertices"] = meshData->getVertices().size();
+    report["triangles"] = meshData->getTriangles().size();
+    report["cpu"] = summarizeFrameTimes(cpuMs);
+    report["frame"] = summarizeFrameTimes(frameMs);
+    report["fps"] = report["frame"]["mean_ms"].get<double>() > 0.0 ? 1000.0 / report["frame"]["mean_ms"].get<double>() : 0.0;
+
+    // The profiler keeps a rolling window, so these cover the last few hundred frames only
+    nlohmann::json scopes = nlohmann::json::array();
+    for (const Profiler::ScopeSummary& summary : Profiler::getSummaries()) {
+        nlohmann::json scope;
+        scope["name"] = summary.name;
+        scope["source"] = summary.source == Profiler::Source::Gpu ? "gpu" : "cpu";
+        scope["mean_ms"] = summary.meanMs;
+        scope["p95_ms"] = summary.p95Ms;
+        scope["max_ms"] = summary.maxMs;
+        scopes.push_back(scope);
+    }
+    report["scopes"] = scopes;
+
+    if (m_offscreen.jsonOut.empty()) {
+        std::cout << report.dump(2) << std::endl;
+    } else {
+        std::ofstream out(m_offscreen.jsonOut);
+        if (!out.is_open()) {
+            LOG_ERROR("Failed to write " << m_offscreen.jsonOut);
+            return 1;
+        }
+        out << report.dump(2) << std::endl;
+        LOG_INFO("Wrote " << m_offscreen.jsonOut);
+    }
+    return 0;
 }
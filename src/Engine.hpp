@@ -3,10 +3,28 @@
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <atomic>
+#include <string>
 
 #include "Renderer.hpp"
 #include "Trackball.hpp"
 #include "Interface.hpp"
+#include "Session.hpp"
+
+// Render benchmark without a visible window: an invisible GLFW window provides the context,
+// frames go into an FBO and the camera follows a scripted path. Under Mesa's llvmpipe on a
+// display-less server run it through xvfb-run.
+struct OffscreenOptions {
+    bool enabled = false;
+    int width = 1280;
+    int height = 720;
+    int frames = 600;
+    int warmupFrames = 30;
+    std::string cameraPath = "orbit"; // orbit, zoom, orbit-zoom
+    bool drawInterface = true;
+    bool poseUpdates = false;         // Re-upload the pose every frame to include the upload path
+    std::string jsonOut;              // Empty = stdout
+};
 
 class Engine
 {
@@ -23,18 +41,51 @@ private:
 
     bool m_isDraggingAxis;
 
+    OffscreenOptions m_offscreen;
+    GLuint m_offscreenFBO;
+    GLuint m_offscreenColor;
+    GLuint m_offscreenDepth;
+    bool m_offscreenReady;          // createOffscreenTarget succeeded, runOffscreen fails early otherwise
+
+    SessionOptions m_session;
+    SessionRecorder m_recorder;
+    SessionPlayer m_player;
+    uint32_t m_frameActions;        // SessionAction bits raised during the last update()
+    double m_cursorX, m_cursorY;    // Last cursor position delivered by a callback, live or replayed
+
+    // Frames still to draw in idle mode. Input asks for a few so ImGui can settle hover and active states
+    int m_redrawFrames;
+    std::atomic<bool> m_wakeRequested; // Set by workers with a result to pick up, before they post the empty event
+    static const int kSettleFrames = 3;
+
 public:
-    Engine();
+    explicit Engine(const OffscreenOptions& offscreen = OffscreenOptions(), const SessionOptions& session = SessionOptions());
     ~Engine();
 
     void update();
-    void run();
+    int run();
+    void requestRedraw(int frames = kSettleFrames);
+    void wake(); // Any thread, ends the idle wait with a redraw
+
+private:
+    bool createOffscreenTarget();
+    void applyCameraPath(int frame, int frameCount);
+    int runOffscreen();
+    void runInteractive();
+    int runReplay();
+    void drawFrame(float elapsed);
+    void dispatchReplayEvent(const SessionEvent& event);
 
 public:
     static void resizeCallback(GLFWwindow* window, int width, int height);
     static void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
     static void cursorPosCallback(GLFWwindow* window, double xoffset, double yoffset);
     static void scrollCallback(GLFWwindow* window, double xoffset, double yoffset);
+    static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+    static void charCallback(GLFWwindow* window, unsigned int codepoint);
+    static void refreshCallback(GLFWwindow* window);
+    static void focusCallback(GLFWwindow* window, int focused);
+    static void cursorEnterCallback(GLFWwindow* window, int entered);
 };
 
 #endif // ENGINE_HPP
@@ -1,11 +1,15 @@
 #include "GenAPI.hpp"
-#include "../Mesh/MeshData.hpp"
-#include <iostream>
+#include "GenCache.hpp"
+#include "../Utilities/Profiler.hpp"
+#include "../Utilities/Logger.hpp"
 #include <sstream>
 #include <fstream>
 #include <cstdlib>
 #include <map>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include "json.hpp"
 
 using json = nlohmann::json;
@@ -16,13 +20,17 @@ using json = nlohmann::json;
 #pragma comment(lib, "wininet.lib")
 #else
 #include <unistd.h>
+#include <signal.h>
 #include <sys/wait.h>
 #endif
 
 namespace GenAPI {
 
+// Every request gets its own request/response files so concurrent jobs never share them
+static std::atomic<unsigned int> s_requestCounter(0);
+
 DeformationGenerator::DeformationGenerator(const std::string& apiUrl)
-    : m_apiUrl(apiUrl)
+    : m_apiUrl(apiUrl), m_cache(new ResponseCache()), m_cacheEnabled(true)
 {
     // Create temp directory for curl operations
 #ifdef _WIN32
@@ -31,7 +39,7 @@ DeformationGenerator::DeformationGenerator(const std::string& apiUrl)
     m_tempDir = std::string(tempPath) + "aucad_genapi\\";
     CreateDirectoryA(m_tempDir.c_str(), NULL);
 #else
-    m_tempDir = "/tmp/aucad_genapi/";
+    m_tempDir = "/tmp/aucad_genapi_" + std::to_string(getpid()) + "/";
     system(("mkdir -p " + m_tempDir).c_str());
 #endif
 }
@@ -134,38 +142,95 @@ GenerationResponse DeformationGenerator::parseResponseJson(const std::string& js
     return response;
 }
 
-bool DeformationGenerator::performHttpRequest(const std::string& jsonData, std::string& response) {
-    std::string requestFile = m_tempDir + "request.json";
-    std::string responseFile = m_tempDir + "response.json";
+bool DeformationGenerator::performHttpRequest(const std::string& jsonData, std::string& response,
+                                              const CancelToken& cancel) {
+    const std::string requestId = std::to_string(s_requestCounter++);
+    std::string requestFile = m_tempDir + "request_" + requestId + ".json";
+    std::string responseFile = m_tempDir + "response_" + requestId + ".json";
 
     // Write request data to file
-    std::ofstream reqFile(requestFile);
-    if (!reqFile.is_open()) {
-        std::cerr << "Failed to create request file: " << requestFile << std::endl;
-        return false;
+    {
+        PROFILE_SCOPE("HTTP write request");
+        std::ofstream reqFile(requestFile);
+        if (!reqFile.is_open()) {
+            LOG_ERROR("Failed to create request file: " << requestFile);
+            return false;
+        }
+        reqFile << jsonData;
+        reqFile.close();
+    }
+
+    const std::string url = getApiUrl() + "/generate-deformations";
+
+    int result = -1;
+    {
+        PROFILE_SCOPE("HTTP round trip");
+#ifdef _WIN32
+        // Construct curl command
+        std::string curlCmd = "curl -s -X POST ";
+        curlCmd += "\"" + url + "\" ";
+        curlCmd += "-H \"Content-Type: application/json\" ";
+        curlCmd += "-d @\"" + requestFile + "\" ";
+        curlCmd += "-o \"" + responseFile + "\"";
+
+        // Execute curl command, cancellation is only honoured before and after the call here
+        result = cancel.isCancelled() ? -1 : system(curlCmd.c_str());
+#else
+        // Run curl as a child process so a cancelled job can kill it mid-request
+        const std::string dataArg = "@" + requestFile;
+        std::vector<const char*> args = {
+            "curl", "-s", "-X", "POST", url.c_str(),
+            "-H", "Content-Type: application/json",
+            "-d", dataArg.c_str(),
+            "-o", responseFile.c_str(),
+            nullptr
+        };
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            execvp("curl", const_cast<char* const*>(args.data()));
+            _exit(127);
+        }
+        else if (pid > 0) {
+            int status = 0;
+            while (true) {
+                pid_t done = waitpid(pid, &status, WNOHANG);
+                if (done == pid) {
+                    result = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+                    break;
+                }
+                if (done < 0) {
+                    break;
+                }
+                if (cancel.isCancelled()) {
+                    kill(pid, SIGTERM);
+                    waitpid(pid, &status, 0);
+                    break;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            }
+        }
+#endif
     }
-    reqFile << jsonData;
-    reqFile.close();
 
-    // Construct curl command
-    std::string curlCmd = "curl -s -X POST ";
-    curlCmd += "\"" + m_apiUrl + "/generate-deformations\" ";
-    curlCmd += "-H \"Content-Type: application/json\" ";
-    curlCmd += "-d @\"" + requestFile + "\" ";
-    curlCmd += "-o \"" + responseFile + "\"";
+    std::remove(requestFile.c_str());
 
-    // Execute curl command
-    int result = system(curlCmd.c_str());
+    if (cancel.isCancelled()) {
+        std::remove(responseFile.c_str());
+        return false;
+    }
 
     if (result != 0) {
-        std::cerr << "Curl command failed with exit code: " << result << std::endl;
+        LOG_ERROR("Curl command failed with exit code: " << result);
+        std::remove(responseFile.c_str());
         return false;
     }
 
     // Read response from file
+    PROFILE_SCOPE("HTTP read response");
     std::ifstream respFile(responseFile);
     if (!respFile.is_open()) {
-        std::cerr << "Failed to read response file: " << responseFile << std::endl;
+        LOG_ERROR("Failed to read response file: " << responseFile);
         return false;
     }
 
@@ -173,14 +238,21 @@ bool DeformationGenerator::performHttpRequest(const std::string& jsonData, std::
     responseStream << respFile.rdbuf();
     response = responseStream.str();
 
-    std::cout << "Response: " << response << std::endl;
+    LOG_DEBUG("Response: " << response.size() << " bytes");
+    LOG_TRACE("Response: " << response);
 
     respFile.close();
+    std::remove(responseFile.c_str());
 
     return !response.empty();
 }
 
 GenerationResponse DeformationGenerator::generateDeformations(const GenerationRequest& request) {
+    return generateDeformations(request, CancelToken());
+}
+
+GenerationResponse DeformationGenerator::generateDeformations(const GenerationRequest& request, const CancelToken& cancel,
+                                                              std::atomic<float>* progress) {
     GenerationResponse result;
 
     if (request.control_points.empty()) {
@@ -201,15 +273,36 @@ GenerationResponse DeformationGenerator::generateDeformations(const GenerationRe
         return result;
     }
 
-    std::cout << "Generating deformations with " << request.control_points.size()
-              << " control points for prompt: \"" << request.prompt << "\"" << std::endl;
+    // Identical requests are answered from the cache without touching the server
+    const uint64_t cacheKey = ResponseCache::hashRequest(request, getApiUrl());
+    if (m_cacheEnabled && m_cache->lookup(cacheKey, result.animation_frames)) {
+        LOG_INFO("Cache hit for prompt: \"" << request.prompt << "\"");
+        result.success = true;
+        result.from_cache = true;
+        if (progress) *progress = 1.0f;
+        return result;
+    }
+    if (progress) *progress = 0.1f;
+
+    LOG_INFO("Generating deformations with " << request.control_points.size()
+             << " control points for prompt: \"" << request.prompt << "\"");
 
     // Construct JSON request
-    std::string jsonRequest = constructRequestJson(request);
+    std::string jsonRequest;
+    {
+        PROFILE_SCOPE("Build request JSON");
+        jsonRequest = constructRequestJson(request);
+    }
 
     // Perform HTTP request
     std::string jsonResponse;
-    bool requestSuccess = performHttpRequest(jsonRequest, jsonResponse);
+    bool requestSuccess = performHttpRequest(jsonRequest, jsonResponse, cancel);
+
+    if (cancel.isCancelled()) {
+        result.success = false;
+        result.error_message = "Cancelled";
+        return result;
+    }
 
     if (!requestSuccess) {
         result.success = false;
@@ -217,14 +310,23 @@ GenerationResponse DeformationGenerator::generateDeformations(const GenerationRe
         return result;
     }
 
+    if (progress) *progress = 0.8f;
+
     // Parse response
-    result = parseResponseJson(jsonResponse);
+    {
+        PROFILE_SCOPE("Parse response JSON");
+        result = parseResponseJson(jsonResponse);
+    }
 
     if (result.success) {
-        std::cout << "Successfully generated " << result.animation_frames.size()
-                  << " animation frames" << std::endl;
+        LOG_INFO("Successfully generated " << result.animation_frames.size()
+                 << " animation frames");
+        if (m_cacheEnabled) {
+            m_cache->store(cacheKey, result.animation_frames);
+        }
+        if (progress) *progress = 1.0f;
     } else {
-        std::cerr << "API request failed: " << result.error_message << std::endl;
+        LOG_ERROR("API request failed: " << result.error_message);
     }
 
     return result;
@@ -242,42 +344,13 @@ GenerationResponse DeformationGenerator::generateAnimation(const std::vector<Con
     return generateDeformations(request);
 }
 
-std::vector<ControlPoint> DeformationGenerator::extractControlPointsFromMesh(MeshData* meshData) {
-    std::vector<ControlPoint> controlPoints;
-
-    if (!meshData) {
-        return controlPoints;
-    }
-
-    const std::vector<bool>& selectedVertices = meshData->getSelectedVertices();
-    const std::vector<Vertex>& vertices = meshData->getVertices();
-
-    for (size_t i = 0; i < selectedVertices.size(); ++i) {
-        if (selectedVertices[i]) {
-            const Vertex& vertex = vertices[i];
-            std::string role = roleFromVertexDescription(vertex.desc);
-            Eigen::Vector3f position = eigenVectorFromPosition(vertex.originalPos);
-
-            controlPoints.emplace_back(static_cast<int>(i), role, position);
-        }
-    }
-
-    return controlPoints;
-}
-
-bool DeformationGenerator::storeAnimationInMesh(MeshData* meshData, const AnimationSequence& frames) {
-    if (!meshData || frames.empty()) {
-        return false;
-    }
-
-    // Store the animation frames in the mesh data
-    meshData->storeAnimationFrames(frames);
-    return true;
+void DeformationGenerator::setCacheDirectory(const std::string& dir) {
+    m_cache->setCacheDirectory(dir);
 }
 
 bool DeformationGenerator::isApiAvailable() {
     // Simple ping test to check if API is available
-    std::string pingCmd = "curl -s --max-time 5 \"" + m_apiUrl + "\" > /dev/null 2>&1";
+    std::string pingCmd = "curl -s --max-time 5 \"" + getApiUrl() + "\" > /dev/null 2>&1";
     int result = system(pingCmd.c_str());
     return result == 0;
 }
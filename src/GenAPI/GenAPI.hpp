@@ -1,9 +1,12 @@
 #ifndef GENAPI_HPP
 #define GENAPI_HPP
 
+#include <atomic>
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <Eigen/Dense>
 
 // Forward declarations
@@ -50,29 +53,50 @@ namespace GenAPI {
     // Response structure
     struct GenerationResponse {
         bool success;
+        bool from_cache;
         std::string error_message;
         AnimationSequence animation_frames;
         
-        GenerationResponse() : success(false) {}
+        GenerationResponse() : success(false), from_cache(false) {}
     };
 
+    // Shared cancellation flag, copies refer to the same flag
+    class CancelToken {
+    private:
+        std::shared_ptr<std::atomic<bool>> m_flag;
+    public:
+        CancelToken() : m_flag(std::make_shared<std::atomic<bool>>(false)) {}
+
+        void cancel() const { *m_flag = true; }
+        bool isCancelled() const { return *m_flag; }
+    };
+
+    class ResponseCache;
+
     // Main API class
     class DeformationGenerator {
     private:
         std::string m_apiUrl;
+        mutable std::mutex m_urlMutex;
         std::string m_tempDir;
+        std::unique_ptr<ResponseCache> m_cache;
+        std::atomic<bool> m_cacheEnabled;
         
         // Internal methods
-        std::string constructRequestJson(const GenerationRequest& request);
-        GenerationResponse parseResponseJson(const std::string& jsonResponse);
-        bool performHttpRequest(const std::string& jsonData, std::string& response);
+        bool performHttpRequest(const std::string& jsonData, std::string& response, const CancelToken& cancel);
         
     public:
         DeformationGenerator(const std::string& apiUrl = "http://localhost:8080");
         ~DeformationGenerator();
+
+        // Wire format, static so tools and benchmarks can use it without a server
+        static std::string constructRequestJson(const GenerationRequest& request);
+        static GenerationResponse parseResponseJson(const std::string& jsonResponse);
         
-        // Main API method
+        // Main API method, progress (if given) goes from 0 to 1
         GenerationResponse generateDeformations(const GenerationRequest& request);
+        GenerationResponse generateDeformations(const GenerationRequest& request, const CancelToken& cancel,
+                                                std::atomic<float>* progress = nullptr);
         
         // Convenience methods
         GenerationResponse generatePose(const std::vector<ControlPoint>& controlPoints, 
@@ -85,8 +109,14 @@ namespace GenAPI {
         bool storeAnimationInMesh(MeshData* meshData, const AnimationSequence& frames);
         
         // Settings
-        void setApiUrl(const std::string& url) { m_apiUrl = url; }
-        const std::string& getApiUrl() const { return m_apiUrl; }
+        void setApiUrl(const std::string& url) { std::lock_guard<std::mutex> lock(m_urlMutex); m_apiUrl = url; }
+        std::string getApiUrl() const { std::lock_guard<std::mutex> lock(m_urlMutex); return m_apiUrl; }
+
+        // Response cache
+        void setCacheEnabled(bool enabled) { m_cacheEnabled = enabled; }
+        bool isCacheEnabled() const { return m_cacheEnabled; }
+        void setCacheDirectory(const std::string& dir);
+        ResponseCache& getCache() { return *m_cache; }
         
         // Status check
         bool isApiAvailable();
@@ -0,0 +1,38 @@
+#include "GenAPI.hpp"
+#include "../Mesh/MeshData.hpp"
+
+// MeshData helpers live apart from GenAPI.cpp so the generator itself builds without GL
+
+namespace GenAPI {
+
+std::vector<ControlPoint> DeformationGenerator::extractControlPointsFromMesh(MeshData* meshData) {
+    std::vector<ControlPoint> controlPoints;
+
+    if (!meshData) {
+        return controlPoints;
+    }
+
+    const std::vector<Vertex>& vertices = meshData->getVertices();
+
+    for (int i : meshData->selectedHandles()) {
+        const Vertex& vertex = vertices[i];
+        std::string role = roleFromVertexDescription(vertex.desc);
+        Eigen::Vector3f position = eigenVectorFromPosition(vertex.originalPos);
+
+        controlPoints.emplace_back(i, role, position);
+    }
+
+    return controlPoints;
+}
+
+bool DeformationGenerator::storeAnimationInMesh(MeshData* meshData, const AnimationSequence& frames) {
+    if (!meshData || frames.empty()) {
+        return false;
+    }
+
+    // Store the animation frames in the mesh data
+    meshData->storeAnimationFrames(frames);
+    return true;
+}
+
+} // namespace GenAPI
@@ -0,0 +1,282 @@
+#include "GenCache.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include "json.hpp"
+#include "../Utilities/FileSystem.hpp"
+#include "../Utilities/Logger.hpp"
+
+using json = nlohmann::json;
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <unistd.h>
+#endif
+
+namespace GenAPI {
+
+namespace {
+    // FNV-1a 64 bit
+    const uint64_t FNV_OFFSET = 14695981039346656037ULL;
+    const uint64_t FNV_PRIME = 1099511628211ULL;
+
+    void hashBytes(uint64_t& h, const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            h ^= bytes[i];
+            h *= FNV_PRIME;
+        }
+    }
+
+    // Only names written by filePath are deleted, anything else in the directory is left alone
+    bool isCacheFileName(const std::string& name) {
+        const size_t hexDigits = 16;
+        if (name.size() != hexDigits + 5 || name.compare(hexDigits, 5, ".json") != 0) return false;
+        for (size_t i = 0; i < hexDigits; ++i) {
+            const char c = name[i];
+            if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) return false;
+        }
+        return true;
+    }
+
+    std::vector<std::string> listDirectory(const std::string& dir) {
+        std::vector<std::string> names;
+#ifdef _WIN32
+        WIN32_FIND_DATAA findData;
+        HANDLE handle = FindFirstFileA((dir + "*").c_str(), &findData);
+        if (handle == INVALID_HANDLE_VALUE) return names;
+        do {
+            names.push_back(findData.cFileName);
+        } while (FindNextFileA(handle, &findData));
+        FindClose(handle);
+#else
+        DIR* handle = opendir(dir.c_str());
+        if (!handle) return names;
+        while (dirent* entry = readdir(handle)) {
+            names.push_back(entry->d_name);
+        }
+        closedir(handle);
+#endif
+        return names;
+    }
+
+    unsigned long processId() {
+#ifdef _WIN32
+        return GetCurrentProcessId();
+#else
+        return static_cast<unsigned long>(getpid());
+#endif
+    }
+
+    // Temporary file names are unique per write, also across processes sharing the directory
+    std::atomic<unsigned int> s_tmpCounter(0);
+}
+
+ResponseCache::ResponseCache(size_t capacity, const std::string& cacheDir)
+    : m_capacity(capacity), m_diskEnabled(true), m_dirCreated(false), m_hits(0), m_diskHits(0), m_misses(0)
+{
+    setCacheDirectory(cacheDir);
+}
+
+uint64_t ResponseCache::hashRequest(const GenerationRequest& request, const std::string& apiUrl) {
+    uint64_t h = FNV_OFFSET;
+
+    // Different servers (or models behind them) give different answers to the same request
+    hashBytes(h, apiUrl.data(), apiUrl.size());
+    hashBytes(h, "\0", 1);
+
+    for (const auto& cp : request.control_points) {
+        hashBytes(h, &cp.id, sizeof(cp.id));
+        hashBytes(h, cp.role.data(), cp.role.size());
+        hashBytes(h, "\0", 1); // Separator so "ab"+"c" != "a"+"bc"
+        hashBytes(h, cp.position.data(), 3 * sizeof(float));
+    }
+
+    hashBytes(h, request.prompt.data(), request.prompt.size());
+    hashBytes(h, "\0", 1);
+    hashBytes(h, &request.length, sizeof(request.length));
+    return h;
+}
+
+bool ResponseCache::lookup(uint64_t key, AnimationSequence& frames) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_index.find(key);
+        if (it != m_index.end()) {
+            m_lru.splice(m_lru.begin(), m_lru, it->second);
+            frames = it->second->frames;
+            m_hits++;
+            return true;
+        }
+    }
+
+    // Disk read happens outside of the lock, parsing can take a while for long sequences
+    if (m_diskEnabled && readFromDisk(key, frames)) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        insertLocked(key, frames);
+        m_hits++;
+        m_diskHits++;
+        return true;
+    }
+
+    m_misses++;
+    return false;
+}
+
+void ResponseCache::store(uint64_t key, const AnimationSequence& frames) {
+    if (frames.empty()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        insertLocked(key, frames);
+    }
+
+    if (m_diskEnabled) {
+        writeToDisk(key, frames);
+    }
+}
+
+void ResponseCache::insertLocked(uint64_t key, const AnimationSequence& frames) {
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+        it->second->frames = frames;
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+        return;
+    }
+
+    m_lru.push_front(Entry{key, frames});
+    m_index[key] = m_lru.begin();
+
+    while (m_lru.size() > m_capacity) {
+        m_index.erase(m_lru.back().key);
+        m_lru.pop_back();
+    }
+}
+
+void ResponseCache::clear(bool includeDisk) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_lru.clear();
+    m_index.clear();
+
+    if (includeDisk && !m_cacheDir.empty()) {
+        for (const std::string& name : listDirectory(m_cacheDir)) {
+            if (isCacheFileName(name)) {
+                std::remove((m_cacheDir + name).c_str());
+            }
+        }
+    }
+}
+
+void ResponseCache::setCapacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_capacity = capacity > 0 ? capacity : 1;
+    while (m_lru.size() > m_capacity) {
+        m_index.erase(m_lru.back().key);
+        m_lru.pop_back();
+    }
+}
+
+void ResponseCache::setCacheDirectory(const std::string& dir) {
+    std::string normalized = dir;
+    if (!normalized.empty() && normalized.back() != '/' && normalized.back() != '\\') {
+        normalized += "/";
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cacheDir = normalized;
+    m_dirCreated = false; // Created on the first write, see writeToDisk
+}
+
+const std::string ResponseCache::getCacheDirectory() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_cacheDir;
+}
+
+size_t ResponseCache::getSize() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_lru.size();
+}
+
+std::string ResponseCache::filePath(uint64_t key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.json", static_cast<unsigned long long>(key));
+    return getCacheDirectory() + name;
+}
+
+bool ResponseCache::readFromDisk(uint64_t key, AnimationSequence& frames) const {
+    std::ifstream file(filePath(key));
+    if (!file.is_open()) {
+        return false;
+    }
+
+    try {
+        json parsedJson = json::parse(file);
+        if (!parsedJson.is_array()) return false;
+
+        AnimationSequence loaded;
+        for (const auto& frameJson : parsedJson) {
+            AnimationFrame frame;
+            for (auto& item : frameJson.items()) {
+                const auto& value = item.value();
+                frame[std::stoi(item.key())] = DeformationDelta(
+                    value["delta_x"].get<float>(),
+                    value["delta_y"].get<float>(),
+                    value["delta_z"].get<float>());
+            }
+            loaded.push_back(frame);
+        }
+
+        frames.swap(loaded);
+        return !frames.empty();
+    } catch (const std::exception& e) {
+        LOG_WARN("Ignoring corrupted cache file " << filePath(key) << ": " << e.what());
+        return false;
+    }
+}
+
+void ResponseCache::writeToDisk(uint64_t key, const AnimationSequence& frames) const {
+    json framesJson = json::array();
+    for (const auto& frame : frames) {
+        json frameJson = json::object();
+        for (const auto& pair : frame) {
+            frameJson[std::to_string(pair.first)] = {
+                {"delta_x", pair.second.delta_x},
+                {"delta_y", pair.second.delta_y},
+                {"delta_z", pair.second.delta_z}
+            };
+        }
+        framesJson.push_back(frameJson);
+    }
+
+    const std::string dir = getCacheDirectory();
+    if (!m_dirCreated) {
+        if (!FileSystem::makeDirectory(dir)) {
+            LOG_ERROR("Failed to create cache directory: " << dir);
+            return;
+        }
+        m_dirCreated = true;
+    }
+
+    // Write to a temporary name first so a concurrent reader never sees a half written file
+    const std::string path = filePath(key);
+    const std::string tmpPath = path + "." + std::to_string(processId()) + "." + std::to_string(s_tmpCounter++) + ".tmp";
+    {
+        std::ofstream file(tmpPath);
+        if (!file.is_open()) {
+            LOG_ERROR("Failed to write cache file: " << path);
+            return;
+        }
+        file << framesJson.dump();
+    }
+#ifdef _WIN32
+    std::remove(path.c_str()); // rename does not replace an existing file on Windows
+#endif
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+    }
+}
+
+} // namespace GenAPI
@@ -0,0 +1,70 @@
+#ifndef GENCACHE_HPP
+#define GENCACHE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "GenAPI.hpp"
+
+namespace GenAPI {
+
+    // Two level cache for generation responses.
+    // Level 1 is an in-memory LRU, level 2 is one JSON file per request under m_cacheDir.
+    class ResponseCache {
+    private:
+        struct Entry {
+            uint64_t key;
+            AnimationSequence frames;
+        };
+
+        size_t m_capacity;
+        std::string m_cacheDir;
+        std::atomic<bool> m_diskEnabled;
+        mutable std::atomic<bool> m_dirCreated; // m_cacheDir is created lazily by the first disk write
+
+        std::list<Entry> m_lru; // Front is most recently used
+        std::unordered_map<uint64_t, std::list<Entry>::iterator> m_index;
+        mutable std::mutex m_mutex;
+
+        std::atomic<int> m_hits;
+        std::atomic<int> m_diskHits;
+        std::atomic<int> m_misses;
+
+        void insertLocked(uint64_t key, const AnimationSequence& frames);
+        std::string filePath(uint64_t key) const;
+        bool readFromDisk(uint64_t key, AnimationSequence& frames) const;
+        void writeToDisk(uint64_t key, const AnimationSequence& frames) const;
+
+    public:
+        ResponseCache(size_t capacity = 32, const std::string& cacheDir = "./cache/genapi/");
+        ~ResponseCache() {}
+
+        static uint64_t hashRequest(const GenerationRequest& request, const std::string& apiUrl);
+
+        bool lookup(uint64_t key, AnimationSequence& frames);
+        void store(uint64_t key, const AnimationSequence& frames);
+        void clear(bool includeDisk = false);
+
+        // Settings
+        void setCapacity(size_t capacity);
+        void setCacheDirectory(const std::string& dir);
+        const std::string getCacheDirectory() const;
+        void setDiskEnabled(bool enabled) { m_diskEnabled = enabled; }
+        bool isDiskEnabled() const { return m_diskEnabled; }
+
+        // Statistics
+        int getHits() const { return m_hits; }
+        int getDiskHits() const { return m_diskHits; }
+        int getMisses() const { return m_misses; }
+        size_t getSize() const;
+        void resetStats() { m_hits = 0; m_diskHits = 0; m_misses = 0; }
+    };
+
+} // namespace GenAPI
+
+#endif // GENCACHE_HPP
@@ -0,0 +1,171 @@
+#include "GenQueue.hpp"
+#include "../Utilities/Profiler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace GenAPI {
+
+GenerationQueue::GenerationQueue(DeformationGenerator& generator, int workerCount)
+    : m_generator(generator), m_stop(false), m_nextId(1), m_activeCount(0)
+{
+    workerCount = std::max(1, workerCount);
+    for (int i = 0; i < workerCount; ++i) {
+        m_workers.emplace_back(&GenerationQueue::workerLoop, this);
+    }
+}
+
+GenerationQueue::~GenerationQueue() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+        for (auto& job : m_jobs) {
+            job->cancel.cancel();
+        }
+    }
+    m_condition.notify_all();
+
+    for (auto& worker : m_workers) {
+        worker.join();
+    }
+}
+
+int GenerationQueue::submit(const GenerationRequest& request) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    GenerationJobPtr job = std::make_shared<GenerationJob>(m_nextId++, request);
+    m_pending.push_back(job);
+    m_jobs.push_back(job);
+    m_condition.notify_one();
+    return job->id;
+}
+
+void GenerationQueue::cancel(int id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Jobs still waiting are finished right away, running ones are stopped by the token
+    for (auto it = m_pending.begin(); it != m_pending.end(); ++it) {
+        if ((*it)->id == id) {
+            (*it)->cancel.cancel();
+            (*it)->status = JobStatus::Cancelled;
+            (*it)->response.error_message = "Cancelled";
+            m_finished.push_back(*it);
+            m_pending.erase(it);
+            return;
+        }
+    }
+
+    for (auto& job : m_jobs) {
+        if (job->id == id) {
+            job->cancel.cancel();
+            return;
+        }
+    }
+}
+
+void GenerationQueue::cancelAll() {
+    std::vector<int> ids;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& job : m_jobs) {
+            if (!job->isFinished()) ids.push_back(job->id);
+        }
+    }
+
+    for (int id : ids) {
+        cancel(id);
+    }
+}
+
+bool GenerationQueue::popFinished(GenerationJobPtr& job) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_finished.empty()) {
+        return false;
+    }
+
+    job = m_finished.front();
+    m_finished.pop_front();
+    return true;
+}
+
+std::vector<GenerationJobPtr> GenerationQueue::getJobs() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_jobs;
+}
+
+void GenerationQueue::clearFinishedJobs() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_jobs.erase(std::remove_if(m_jobs.begin(), m_jobs.end(),
+                                [](const GenerationJobPtr& job) { return job->isFinished(); }),
+                 m_jobs.end());
+}
+
+void GenerationQueue::setFinishedCallback(const std::function<void()>& callback) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_finishedCallback = callback;
+}
+
+int GenerationQueue::getPendingCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return static_cast<int>(m_pending.size());
+}
+
+void GenerationQueue::workerLoop() {
+    Profiler::setThreadName("generation");
+
+    while (true) {
+        GenerationJobPtr job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_stop || !m_pending.empty(); });
+            if (m_stop) {
+                return;
+            }
+
+            job = m_pending.front();
+            m_pending.pop_front();
+            job->status = JobStatus::Running;
+            m_activeCount++;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        JobStatus finalStatus;
+        try {
+            job->response = m_generator.generateDeformations(job->request, job->cancel, &job->progress);
+            if (job->cancel.isCancelled()) {
+                finalStatus = JobStatus::Cancelled;
+            } else {
+                finalStatus = job->response.success ? JobStatus::Done : JobStatus::Failed;
+            }
+        } catch (const std::exception& e) {
+            job->response.success = false;
+            job->response.error_message = "Exception during generation: " + std::string(e.what());
+            finalStatus = JobStatus::Failed;
+        }
+        job->elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::function<void()> callback;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            job->status = finalStatus;
+            m_finished.push_back(job);
+            m_activeCount--;
+            callback = m_finishedCallback;
+        }
+        if (callback) {
+            callback();
+        }
+    }
+}
+
+const char* jobStatusName(JobStatus status) {
+    switch (status) {
+        case JobStatus::Queued:    return "Queued";
+        case JobStatus::Running:   return "Running";
+        case JobStatus::Done:      return "Done";
+        case JobStatus::Failed:    return "Failed";
+        case JobStatus::Cancelled: return "Cancelled";
+    }
+    return "Unknown";
+}
+
+} // namespace GenAPI
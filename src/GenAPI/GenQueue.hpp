@@ -0,0 +1,95 @@
+#ifndef GENQUEUE_HPP
+#define GENQUEUE_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "GenAPI.hpp"
+
+namespace GenAPI {
+
+    enum class JobStatus {
+        Queued,
+        Running,
+        Done,
+        Failed,
+        Cancelled
+    };
+
+    // A single generation request tracked by the queue
+    struct GenerationJob {
+        int id;
+        GenerationRequest request;
+        CancelToken cancel;
+
+        std::atomic<JobStatus> status;
+        std::atomic<float> progress;
+
+        // Written by the worker before status leaves Running, read-only afterwards
+        GenerationResponse response;
+        double elapsedSeconds;
+
+        GenerationJob(int id, const GenerationRequest& request)
+            : id(id), request(request), status(JobStatus::Queued), progress(0.0f), elapsedSeconds(0.0) {}
+
+        bool isFinished() const {
+            JobStatus s = status;
+            return s == JobStatus::Done || s == JobStatus::Failed || s == JobStatus::Cancelled;
+        }
+    };
+
+    typedef std::shared_ptr<GenerationJob> GenerationJobPtr;
+
+    // Bounded worker pool in front of DeformationGenerator.
+    // Jobs are submitted and collected from the render thread, workers only touch the job they run.
+    class GenerationQueue {
+    private:
+        DeformationGenerator& m_generator;
+
+        std::vector<std::thread> m_workers;
+        std::deque<GenerationJobPtr> m_pending;
+        std::deque<GenerationJobPtr> m_finished; // Waiting to be collected by the render thread
+        std::vector<GenerationJobPtr> m_jobs;    // Every job for display, in submit order
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_condition;
+        bool m_stop;
+        int m_nextId;
+        std::atomic<int> m_activeCount;
+        std::function<void()> m_finishedCallback; // Guarded by m_mutex, invoked on the worker thread
+
+        void workerLoop();
+
+    public:
+        GenerationQueue(DeformationGenerator& generator, int workerCount = 2);
+        ~GenerationQueue();
+
+        int submit(const GenerationRequest& request);
+        void cancel(int id);
+        void cancelAll();
+
+        // Render thread hand-off, returns false when nothing finished since the last call
+        bool popFinished(GenerationJobPtr& job);
+
+        std::vector<GenerationJobPtr> getJobs() const;
+        void clearFinishedJobs();
+
+        // Called from the worker after a job finished, e.g. to wake a render loop that waits for events
+        void setFinishedCallback(const std::function<void()>& callback);
+
+        int getActiveCount() const { return m_activeCount; }
+        int getPendingCount() const;
+        int getWorkerCount() const { return static_cast<int>(m_workers.size()); }
+    };
+
+    const char* jobStatusName(JobStatus status);
+
+} // namespace GenAPI
+
+#endif // GENQUEUE_HPP
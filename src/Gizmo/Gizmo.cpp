@@ -1,5 +1,5 @@
 #include "Gizmo.hpp"
-#include <iostream>
+#include "../Utilities/Logger.hpp"
 
 Gizmo::Gizmo(Shader* shader) {
     float rad = 0.05f;
@@ -101,7 +101,7 @@ Gizmo::AxisDir Gizmo::pickTranslation(const Eigen::Vector3f& cam_org, const Eige
         }
     }
 
-    std::cout << "Closest Axis (Cone): " << (int)closestAxis << "\n";
+    LOG_DEBUG("Closest Axis (Cone): " << (int)closestAxis);
     m_selectedAxis = closestAxis;
     return closestAxis;
 }
@@ -31,6 +31,7 @@ public:
     const Eigen::Vector3f& getTranslation() { return m_translation; }
 
     const AxisDir getSelectedAxis() { return m_selectedAxis; }
+    const Object::Axis* getAxis() const { return m_axis; }
     void clearSelection() { m_selectedAxis = None; }
 
     AxisDir pickTranslation(const Eigen::Vector3f& cam_org, const Eigen::Vector3f& nearPoint);
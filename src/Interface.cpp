@@ -5,15 +5,27 @@
 #include <imgui_impl_opengl3.h>
 #include "Mesh/MeshData.hpp"
 #include "GenAPI/GenAPI.hpp"
-#include <iostream>
+#include "GenAPI/GenCache.hpp"
+#include "GenAPI/GenQueue.hpp"
+#include "Utilities/TaskScheduler.hpp"
+#include "Utilities/GpuProfiler.hpp"
+#include "Utilities/Logger.hpp"
+#include <cmath>
+#include <sstream>
 #include <thread>
 
 Interface::Interface(GLFWwindow* window, int screen_width, int screen_height)
-    : m_window(window), m_width(screen_width), m_height(screen_height), m_computeDeformedPos(false), safeTimeframe(false), m_weightThreshold(0.1f),
+    : m_window(window), m_width(screen_width), m_height(screen_height), m_visualizeMode(1), m_computeDeformedPos(false), safeTimeframe(false), m_weightThreshold(0.1f),
       doRefresh(false), timestep(0.0f), m_meshData(nullptr), m_showVertexPanel(true),
       m_generator(std::make_unique<GenAPI::DeformationGenerator>()), m_showGenerationPanel(true),
-      m_animationLength(1), m_apiUrl("http://localhost:8080"), m_isGenerating(false), m_apiConnected(false),
-      m_processingAllFrames(false), m_currentProcessingFrame(0), m_totalFramesToProcess(11)
+      m_animationLength(1), m_apiUrl("http://localhost:8080"), m_apiConnected(false),
+      m_promptPerLine(false), m_autoApply(true), m_bakeDynamics(false), m_bakeSubsteps(4), m_bakeInertia(0.1f),
+      m_bakeDamping(0.2f), m_appliedJobId(-1),
+      m_solveAllFrames(false), m_deformer(ARAP), m_livePreview(true), m_arapMaxIterations(10), m_arapTolerance(0.0f), m_arapTimeBudgetMs(0.0f),
+      m_arapMultilevel(false), m_arapFineIterations(2), m_roiEnabled(false), m_roiFromSelection(false), m_roiRadius(0.2f),
+      m_apiCheckInFlight(false), m_apiRecheck(false), m_showTaskPanel(false), m_showProfilerPanel(false),
+      m_showMemoryPanel(false), m_memoryReportTime(0.0),
+      m_idleMode(true), m_playing(false), m_playbackFps(30), m_playbackSpeed(2.0f), m_pendingPlaybackSeconds(0.0f), m_frameMs(0.0f)
 {
     // Setup Dear ImGui context
     IMGUI_CHECKVERSION();
@@ -30,52 +42,113 @@ Interface::Interface(GLFWwindow* window, int screen_width, int screen_height)
     ImGui_ImplOpenGL3_Init("#version 330");
 
     // Initialize generation panel
+    m_queue = std::make_unique<GenAPI::GenerationQueue>(*m_generator, 2);
     memset(m_promptBuffer, 0, sizeof(m_promptBuffer));
     strcpy(m_promptBuffer, "make the character wave");
+    memset(m_tracePath, 0, sizeof(m_tracePath));
+    strcpy(m_tracePath, "trace.json");
+    memset(m_memoryReportPath, 0, sizeof(m_memoryReportPath));
+    strcpy(m_memoryReportPath, "memory.json");
 
     // Check API connection in background
-    std::thread([this]() {
-        checkApiConnection();
-    }).detach();
+    checkApiConnection();
 }
 
 Interface::~Interface() {
+    m_queue.reset(); // Joins the workers before the generator goes away
+    m_apiRecheck = false;
+    while (m_apiCheckInFlight) {
+        TaskScheduler::instance().pumpMainThread();
+        std::this_thread::yield();
+    }
+    if (m_apiCheckThread.joinable()) {
+        m_apiCheckThread.join();
+    }
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
 }
 
+void Interface::setWakeCallback(const std::function<void()>& callback) {
+    m_queue->setFinishedCallback(callback);
+}
+
+void Interface::setLayoutPersistence(bool enabled) {
+    ImGui::GetIO().IniFilename = enabled ? "imgui.ini" : nullptr;
+}
+
+void Interface::detachInputCallbacks() {
+    ImGui_ImplGlfw_RestoreCallbacks(m_window);
+}
+
+void Interface::replayEvent(const SessionEvent& event) {
+    switch (event.type) {
+        case SessionEventType::CursorPos:
+            ImGui_ImplGlfw_CursorPosCallback(m_window, event.x, event.y);
+            break;
+        case SessionEventType::MouseButton:
+            ImGui_ImplGlfw_MouseButtonCallback(m_window, event.a, event.action, event.mods);
+            break;
+        case SessionEventType::Scroll:
+            ImGui_ImplGlfw_ScrollCallback(m_window, event.x, event.y);
+            break;
+        case SessionEventType::Key:
+            ImGui_ImplGlfw_KeyCallback(m_window, event.a, event.b, event.action, event.mods);
+            break;
+        case SessionEventType::Char:
+            ImGui_ImplGlfw_CharCallback(m_window, static_cast<unsigned int>(event.a));
+            break;
+        case SessionEventType::Focus:
+            ImGui_ImplGlfw_WindowFocusCallback(m_window, event.a);
+            break;
+        case SessionEventType::CursorEnter:
+            ImGui_ImplGlfw_CursorEnterCallback(m_window, event.a);
+            break;
+        default:
+            break;
+    }
+}
+
+const bool Interface::hasBackgroundWork() {
+    return m_apiCheckInFlight || m_queue->getActiveCount() > 0 || m_queue->getPendingCount() > 0 ||
+           (m_meshData && (m_meshData->isBaking() || m_meshData->isSolving()));
+}
+
 void Interface::resize(int width, int height) {
     m_width = width;
     m_height = height;
 }
 
 void Interface::draw() {
+    PROFILE_SCOPE("Interface::draw");
+
     m_computeDeformedPos = false;
+    m_solveAllFrames = false;
     safeTimeframe = false;
     doRefresh = false;
 
-    // Handle ARAP all frames processing
-    if (m_processingAllFrames) {
-        if (m_currentProcessingFrame < m_totalFramesToProcess) {
-            timestep = static_cast<float>(m_currentProcessingFrame);
-            m_computeDeformedPos = true;
-            safeTimeframe = true;
-            doRefresh = true;
-            m_currentProcessingFrame++;
-        } else {
-            // Finished processing all frames
-            m_processingAllFrames = false;
-            m_currentProcessingFrame = 0;
+    // Playback follows wall-clock time, a frame over budget skips ahead instead of slowing the animation down
+    if (m_playing) {
+        const float end = (m_meshData && m_meshData->hasAnimationFrames())
+            ? static_cast<float>(m_meshData->getAnimationFrameCount())
+            : 10.0f;
+        timestep += m_pendingPlaybackSeconds * m_playbackSpeed;
+        if (timestep > end) {
+            timestep = std::fmod(timestep, end);
         }
+        doRefresh = true;
     }
+    m_pendingPlaybackSeconds = 0.0f;
+
+    // Finished generation jobs are handed over here, on the render thread
+    collectFinishedJobs();
 
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
 
     // Position at the bottom
-    float windowHeight = 200.0f;
+    float windowHeight = 250.0f;
     ImGui::SetNextWindowPos(ImVec2(0, m_height - windowHeight));
     ImGui::SetNextWindowSize(ImVec2(m_width, windowHeight));
 
@@ -86,6 +159,10 @@ void Interface::draw() {
         m_selectionMode = SelectionMode::Vertex;
     }
     ImGui::SameLine();
+    if (ImGui::RadioButton("Triangle", m_selectionMode == SelectionMode::Triangle)) {
+        m_selectionMode = SelectionMode::Triangle;
+    }
+    ImGui::SameLine();
     if (ImGui::RadioButton("Axis", m_selectionMode == SelectionMode::AxisDebug)) {
         m_selectionMode = SelectionMode::AxisDebug;
     }
@@ -99,33 +176,143 @@ void Interface::draw() {
     ImGui::SameLine();
     if (ImGui::Button("Normal")) m_visualizeMode = 2;
     ImGui::SameLine();
-    if (ImGui::Button("Compute ARAP")) m_computeDeformedPos = true;
+    if (ImGui::Button("Curvature")) m_visualizeMode = 3;
+    ImGui::SameLine();
+    const char* computeLabel = m_deformer == Laplacian ? "Compute Laplacian" : m_deformer == Skinning ? "Compute weights" : "Compute ARAP";
+    if (ImGui::Button(computeLabel)) m_computeDeformedPos = true;
     ImGui::SameLine();
     if (ImGui::Button("Save Timeframe")) safeTimeframe = true;
     ImGui::SameLine();
-    if (ImGui::Button("ARAP all frames")) {
-        // Start processing all full frames from 0.0 to 10.0
-        m_processingAllFrames = true;
-        m_currentProcessingFrame = 0;
-        m_totalFramesToProcess = 11; // 0, 1, 2, ..., 10
-    }
-    
-    // Show progress if processing
-    if (m_processingAllFrames) {
+    if (ImGui::Button("ARAP all frames")) m_solveAllFrames = true;
+
+    // Solves run on the solver thread, the viewport keeps drawing meanwhile
+    if (m_meshData && m_meshData->isSolving()) {
         ImGui::SameLine();
-        ImGui::Text("Processing frame %d/%d", m_currentProcessingFrame, m_totalFramesToProcess);
+        ImGui::TextColored(ImVec4(1.0f, 1.0f, 0.0f, 1.0f), "Solving...");
     }
 
     if (ImGui::SliderFloat("Timestep", &timestep, 0.0f, 10.0f, "%.1f", ImGuiSliderFlags_AlwaysClamp)) {
         doRefresh = true;
     }
 
+    if (ImGui::Button(m_playing ? "Pause" : "Play")) m_playing = !m_playing;
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(120.0f);
+    ImGui::SliderFloat("Speed", &m_playbackSpeed, 0.1f, 10.0f, "%.1f /s");
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(120.0f);
+    ImGui::SliderInt("Playback FPS", &m_playbackFps, 5, 120);
+    ImGui::SameLine();
+    ImGui::Checkbox("Idle Mode", &m_idleMode);
+    ImGui::SameLine();
+    ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f), "%.1f ms/frame", m_frameMs);
+
+    if (m_visualizeMode == 3) {
+        ImGui::SliderFloat("Curvature Range", &m_weightThreshold, 0.001f, 1.0f, "%.3f", ImGuiSliderFlags_Logarithmic);
+    }
+
+    if (m_meshData) {
+        const PoseUpdateTimings& timings = m_meshData->getPoseUpdateTimings();
+        ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f), "Pose update: positions %.2f ms, normals %.2f ms + %.2f ms upload",
+                           timings.positionUploadMs, timings.normalComputeMs, timings.normalUploadMs);
+    }
+
+    ImGui::Text("Deformer:");
+    ImGui::SameLine();
+    ImGui::RadioButton("ARAP", &m_deformer, ARAP);
+    ImGui::SameLine();
+    ImGui::RadioButton("Laplacian", &m_deformer, Laplacian);
+    ImGui::SameLine();
+    ImGui::RadioButton("Skinning", &m_deformer, Skinning);
+    ImGui::SameLine();
+
+    if (m_deformer == Laplacian) {
+        // Linear and prefactorized, cheap enough to follow the gizmo
+        ImGui::Checkbox("Live while dragging", &m_livePreview);
+
+        const ArapSolveStats* stats = m_meshData ? &m_meshData->getLastSolveStats() : nullptr;
+        if (stats && stats->iterations == 0 && stats->ms > 0.0) {
+            ImGui::SameLine();
+            ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f), "Last solve: %.2f ms", stats->ms);
+        }
+    }
+    else if (m_deformer == Skinning) {
+        // Dragging and playback only move the handles, bake with ARAP for the final pose
+        if (m_meshData && m_meshData->isComputingWeights()) {
+            ImGui::TextColored(ImVec4(1.0f, 1.0f, 0.0f, 1.0f), "Computing weights...");
+        }
+        else if (m_meshData && m_meshData->getSkinHandleCount() > 0) {
+            ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f), "Weights for %d handles, %d per vertex",
+                               m_meshData->getSkinHandleCount(), HandleWeights::kInfluences);
+        }
+        else {
+            ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f), "Select handles to compute weights");
+        }
+    }
+    else {
+        // Fewer iterations or a tighter budget trade accuracy for latency while dragging
+        ImGui::SetNextItemWidth(100.0f);
+        ImGui::SliderInt("Max iterations", &m_arapMaxIterations, 1, 50);
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(100.0f);
+        ImGui::SliderFloat("Tolerance", &m_arapTolerance, 0.0f, 0.1f, m_arapTolerance > 0.0f ? "%.1e" : "off",
+                           ImGuiSliderFlags_Logarithmic);
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(100.0f);
+        ImGui::SliderFloat("Budget", &m_arapTimeBudgetMs, 0.0f, 500.0f, m_arapTimeBudgetMs > 0.0f ? "%.0f ms" : "off");
+        ImGui::SameLine();
+        ImGui::Checkbox("Multilevel", &m_arapMultilevel);
+        if (m_arapMultilevel) {
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(100.0f);
+            ImGui::SliderInt("Fine iterations", &m_arapFineIterations, 1, 10);
+        }
+
+        // Only the region is solved and uploaded, the ring around it is held in place
+        ImGui::Checkbox("Region", &m_roiEnabled);
+        if (m_roiEnabled) {
+            ImGui::SameLine();
+            if (ImGui::RadioButton("Around moved handles", !m_roiFromSelection)) m_roiFromSelection = false;
+            ImGui::SameLine();
+            if (ImGui::RadioButton("Selected triangles", m_roiFromSelection)) m_roiFromSelection = true;
+            if (!m_roiFromSelection) {
+                ImGui::SameLine();
+                ImGui::SetNextItemWidth(120.0f);
+                ImGui::SliderFloat("Radius", &m_roiRadius, 0.01f, 1.0f, "%.2f x size", ImGuiSliderFlags_Logarithmic);
+            }
+        }
+
+        if (m_meshData && m_meshData->getLastSolveStats().iterations > 0) {
+            const ArapSolveStats& stats = m_meshData->getLastSolveStats();
+            const char* stop = stats.stop == ArapSolveStats::Stop::Tolerance ? "converged" :
+                               stats.stop == ArapSolveStats::Stop::TimeBudget ? "out of budget" : "iteration cap";
+            const int count = m_meshData->getLastRoiVertexCount();
+            ImGui::SameLine();
+            if (count >= 0) {
+                ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f), "Last solve: %d iterations, energy %.3e, %.1f ms, %s, %d of %d vertices",
+                                   stats.iterations, stats.energy, stats.ms, stop, count, static_cast<int>(m_meshData->getVertices().size()));
+            }
+            else {
+                ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f), "Last solve: %d iterations, energy %.3e, %.1f ms, %s",
+                                   stats.iterations, stats.energy, stats.ms, stop);
+            }
+        }
+    }
+
     ImGui::Separator();
 
     ImGui::Text("Panels:");
     ImGui::Checkbox("Show Vertex Panel", &m_showVertexPanel);
     ImGui::SameLine();
     ImGui::Checkbox("Show Generation Panel", &m_showGenerationPanel);
+    ImGui::SameLine();
+    ImGui::Checkbox("Show Task Panel", &m_showTaskPanel);
+    ImGui::SameLine();
+    if (ImGui::Checkbox("Show Profiler", &m_showProfilerPanel)) {
+        Profiler::setEnabled(m_showProfilerPanel);
+    }
+    ImGui::SameLine();
+    ImGui::Checkbox("Show Memory", &m_showMemoryPanel);
 
     ImGui::End();
 
@@ -135,8 +322,17 @@ void Interface::draw() {
     // Draw generation panel
     drawGenerationPanel();
 
+    drawTaskPanel();
+
+    drawProfilerPanel();
+
+    drawMemoryPanel();
+
     ImGui::Render();
-    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    {
+        PROFILE_GPU_SCOPE("Draw UI");
+        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    }
 }
 
 void Interface::drawVertexPanel() {
@@ -145,18 +341,14 @@ void Interface::drawVertexPanel() {
     // Position the vertex panel on the right side
     float panelWidth = 350.0f;
     ImGui::SetNextWindowPos(ImVec2(m_width - panelWidth, 0));
-    ImGui::SetNextWindowSize(ImVec2(panelWidth, m_height - 200.0f)); // Leave space for the controls panel
+    ImGui::SetNextWindowSize(ImVec2(panelWidth, m_height - 250.0f)); // Leave space for the controls panel
 
     ImGui::Begin("Selected Vertices", &m_showVertexPanel, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize);
 
     const std::vector<bool>& selectedVertices = m_meshData->getSelectedVertices();
     const std::vector<class Vertex>& vertices = m_meshData->getVertices();
 
-    // Count selected vertices
-    int selectedCount = 0;
-    for (bool selected : selectedVertices) {
-        if (selected) selectedCount++;
-    }
+    const int selectedCount = static_cast<int>(m_meshData->selectedHandles().size());
 
     ImGui::Text("Selected Vertices: %d", selectedCount);
     ImGui::Separator();
@@ -263,7 +455,7 @@ void Interface::drawGenerationPanel() {
     // Position the generation panel on the left side
     float panelWidth = 400.0f;
     ImGui::SetNextWindowPos(ImVec2(0, 0));
-    ImGui::SetNextWindowSize(ImVec2(panelWidth, m_height - 200.0f)); // Leave space for controls panel
+    ImGui::SetNextWindowSize(ImVec2(panelWidth, m_height - 250.0f)); // Leave space for controls panel
 
     ImGui::Begin("Pose/Animation Generation", &m_showGenerationPanel, ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize);
 
@@ -277,9 +469,7 @@ void Interface::drawGenerationPanel() {
     }
     ImGui::SameLine();
     if (ImGui::SmallButton("Refresh")) {
-        std::thread([this]() {
-            checkApiConnection();
-        }).detach();
+        checkApiConnection();
     }
 
     ImGui::Separator();
@@ -295,20 +485,14 @@ void Interface::drawGenerationPanel() {
         m_apiUrl = std::string(urlBuffer);
         m_generator->setApiUrl(m_apiUrl);
         // Check connection when URL changes
-        std::thread([this]() {
-            checkApiConnection();
-        }).detach();
+        checkApiConnection();
     }
 
     ImGui::Separator();
 
     // Control Points Info
     if (m_meshData) {
-        const std::vector<bool>& selectedVertices = m_meshData->getSelectedVertices();
-        int selectedCount = 0;
-        for (bool selected : selectedVertices) {
-            if (selected) selectedCount++;
-        }
+        const int selectedCount = static_cast<int>(m_meshData->selectedHandles().size());
 
         ImGui::Text("Control Points: %d", selectedCount);
 
@@ -340,9 +524,22 @@ void Interface::drawGenerationPanel() {
         ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f), "(Animation)");
     }
 
+    // Frames are integrated in order instead of solved one by one, the mesh lags behind the handles
+    ImGui::Checkbox("Secondary motion", &m_bakeDynamics);
+    if (m_bakeDynamics) {
+        ImGui::SliderInt("Substeps", &m_bakeSubsteps, 1, 16, "%d per frame");
+        ImGui::SliderFloat("Inertia", &m_bakeInertia, 0.001f, 1.0f, "%.3f", ImGuiSliderFlags_Logarithmic);
+        ImGui::SliderFloat("Damping", &m_bakeDamping, 0.0f, 1.0f, "%.2f per frame");
+    }
+
     ImGui::Separator();
 
     // Animation Status
+    if (m_meshData && m_meshData->isBaking()) {
+        ImGui::TextColored(ImVec4(1.0f, 1.0f, 0.0f, 1.0f), "Baking animation...");
+        ImGui::Separator();
+    }
+
     if (m_meshData && m_meshData->hasAnimationFrames()) {
         ImGui::TextColored(ImVec4(0.0f, 1.0f, 0.0f, 1.0f), "Animation Loaded:");
         ImGui::Text("Frames: %d", m_meshData->getAnimationFrameCount());
@@ -356,7 +553,11 @@ void Interface::drawGenerationPanel() {
     }
 
     // Generation Buttons
-    bool canGenerate = m_meshData && m_apiConnected && !m_isGenerating && strlen(m_promptBuffer) > 0;
+    ImGui::Checkbox("One job per line", &m_promptPerLine);
+    ImGui::SameLine();
+    ImGui::Checkbox("Auto apply", &m_autoApply);
+
+    bool canGenerate = m_meshData && m_apiConnected && strlen(m_promptBuffer) > 0;
 
     if (!canGenerate) {
         ImGui::PushStyleVar(ImGuiStyleVar_Alpha, 0.5f);
@@ -373,10 +574,7 @@ void Interface::drawGenerationPanel() {
     }
 
     // Generation Status
-    if (m_isGenerating) {
-        ImGui::TextColored(ImVec4(1.0f, 1.0f, 0.0f, 1.0f), "Generating...");
-        ImGui::ProgressBar(-1.0f * ImGui::GetTime(), ImVec2(-1, 0), "");
-    } else if (!m_lastError.empty()) {
+    if (!m_lastError.empty()) {
         ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "Error:");
         ImGui::TextWrapped("%s", m_lastError.c_str());
         if (ImGui::Button("Clear Error")) {
@@ -384,6 +582,50 @@ void Interface::drawGenerationPanel() {
         }
     }
 
+    drawJobList();
+
+    ImGui::Separator();
+
+    // Response Cache
+    {
+        GenAPI::ResponseCache& cache = m_generator->getCache();
+
+        bool cacheEnabled = m_generator->isCacheEnabled();
+        if (ImGui::Checkbox("Use Cache", &cacheEnabled)) {
+            m_generator->setCacheEnabled(cacheEnabled);
+        }
+        ImGui::SameLine();
+        bool diskEnabled = cache.isDiskEnabled();
+        if (ImGui::Checkbox("Disk Cache", &diskEnabled)) {
+            cache.setDiskEnabled(diskEnabled);
+        }
+
+        ImGui::Text("Cache: %d hits (%d disk) / %d misses, %d in memory",
+                    cache.getHits(), cache.getDiskHits(), cache.getMisses(), static_cast<int>(cache.getSize()));
+
+        static char cacheDirBuffer[256];
+        if (strlen(cacheDirBuffer) == 0) {
+            strncpy(cacheDirBuffer, cache.getCacheDirectory().c_str(), sizeof(cacheDirBuffer) - 1);
+        }
+
+        ImGui::Text("Cache Directory:");
+        if (ImGui::InputText("##cache_dir", cacheDirBuffer, sizeof(cacheDirBuffer), ImGuiInputTextFlags_EnterReturnsTrue)) {
+            m_generator->setCacheDirectory(std::string(cacheDirBuffer));
+        }
+
+        if (ImGui::Button("Clear Memory")) {
+            cache.clear();
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Clear Disk")) {
+            cache.clear(true);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Reset Counters")) {
+            cache.resetStats();
+        }
+    }
+
     ImGui::Separator();
 
     // Quick Preset Prompts
@@ -422,63 +664,346 @@ void Interface::drawGenerationPanel() {
     ImGui::End();
 }
 
-void Interface::checkApiConnection() {
-    m_apiConnected = m_generator->isApiAvailable();
+void Interface::drawJobList() {
+    std::vector<GenAPI::GenerationJobPtr> jobs = m_queue->getJobs();
+    if (jobs.empty()) return;
+
+    ImGui::Separator();
+    ImGui::Text("Jobs: %d running on %d workers", m_queue->getActiveCount(), m_queue->getWorkerCount());
+    ImGui::SameLine();
+    if (ImGui::SmallButton("Cancel All")) {
+        m_queue->cancelAll();
+    }
+    ImGui::SameLine();
+    if (ImGui::SmallButton("Clear Finished")) {
+        m_queue->clearFinishedJobs();
+    }
+
+    // One row per job so results of different prompts can be compared and swapped in
+    if (ImGui::BeginTable("##jobs", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerH | ImGuiTableFlags_SizingStretchProp)) {
+        ImGui::TableSetupColumn("Prompt", ImGuiTableColumnFlags_WidthStretch, 3.0f);
+        ImGui::TableSetupColumn("Status", ImGuiTableColumnFlags_WidthStretch, 2.0f);
+        ImGui::TableSetupColumn("Result", ImGuiTableColumnFlags_WidthStretch, 2.0f);
+        ImGui::TableSetupColumn("", ImGuiTableColumnFlags_WidthFixed, 50.0f);
+        ImGui::TableHeadersRow();
+
+        for (const auto& job : jobs) {
+            ImGui::PushID(job->id);
+            ImGui::TableNextRow();
+
+            ImGui::TableSetColumnIndex(0);
+            if (job->id == m_appliedJobId) {
+                ImGui::TextColored(ImVec4(0.4f, 0.8f, 1.0f, 1.0f), "%s", job->request.prompt.c_str());
+            } else {
+                ImGui::TextWrapped("%s", job->request.prompt.c_str());
+            }
+
+            ImGui::TableSetColumnIndex(1);
+            GenAPI::JobStatus status = job->status;
+            if (status == GenAPI::JobStatus::Running) {
+                ImGui::ProgressBar(job->progress, ImVec2(-1, 0));
+            } else {
+                ImGui::Text("%s", GenAPI::jobStatusName(status));
+            }
+
+            ImGui::TableSetColumnIndex(2);
+            if (status == GenAPI::JobStatus::Done) {
+                ImGui::Text("%d fr, %.2fs%s", static_cast<int>(job->response.animation_frames.size()),
+                            job->elapsedSeconds, job->response.from_cache ? " (cached)" : "");
+            } else if (status == GenAPI::JobStatus::Failed) {
+                ImGui::TextWrapped("%s", job->response.error_message.c_str());
+            }
+
+            ImGui::TableSetColumnIndex(3);
+            if (!job->isFinished()) {
+                if (ImGui::SmallButton("Cancel")) {
+                    m_queue->cancel(job->id);
+                }
+            } else if (status == GenAPI::JobStatus::Done) {
+                if (ImGui::SmallButton("Apply")) {
+                    applyJob(*job);
+                }
+            }
+
+            ImGui::PopID();
+        }
+        ImGui::EndTable();
+    }
 }
 
-void Interface::generateDeformations() {
-    if (!m_meshData || m_isGenerating) {
+void Interface::drawTaskPanel() {
+    if (!m_showTaskPanel) return;
+
+    TaskScheduler& scheduler = TaskScheduler::instance();
+
+    ImGui::SetNextWindowPos(ImVec2(m_width * 0.5f - 200.0f, 20.0f), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(400.0f, 300.0f), ImGuiCond_FirstUseEver);
+    ImGui::Begin("Tasks", &m_showTaskPanel);
+
+    // Restarting the pool on every drag step would be wasteful, apply once the slider is released
+    static int workerCount = 0;
+    if (workerCount == 0) workerCount = scheduler.getWorkerCount();
+    ImGui::SliderInt("Workers", &workerCount, 1, std::max(16, TaskScheduler::defaultWorkerCount() + 1));
+    if (ImGui::IsItemDeactivatedAfterEdit()) {
+        scheduler.setWorkerCount(workerCount);
+    }
+    ImGui::SameLine();
+    if (ImGui::SmallButton("Reset Stats")) {
+        scheduler.resetStats();
+    }
+
+    if (ImGui::BeginTable("##taskstats", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerH | ImGuiTableFlags_SizingStretchProp)) {
+        ImGui::TableSetupColumn("Task");
+        ImGui::TableSetupColumn("Runs");
+        ImGui::TableSetupColumn("Mean ms");
+        ImGui::TableSetupColumn("Max ms");
+        ImGui::TableHeadersRow();
+
+        for (const auto& entry : scheduler.getStats()) {
+            const TaskScheduler::TaskStats& stats = entry.second;
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", entry.first.c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%d", stats.count);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.count > 0 ? stats.totalMs / stats.count : 0.0);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.maxMs);
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
+
+void Interface::drawProfilerPanel() {
+    if (!m_showProfilerPanel) return;
+
+    ImGui::SetNextWindowPos(ImVec2(20.0f, 20.0f), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(420.0f, 320.0f), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowBgAlpha(0.85f);
+    if (!ImGui::Begin("Profiler", &m_showProfilerPanel)) {
+        ImGui::End();
         return;
     }
 
-    m_isGenerating = true;
-    m_lastError.clear();
+    // Closing the window with its own button stops the scopes too
+    if (!m_showProfilerPanel) {
+        Profiler::setEnabled(false);
+    }
 
-    // Run generation in background thread
-    std::thread([this]() {
-        try {
-            // Extract control points from selected vertices
-            std::vector<GenAPI::ControlPoint> controlPoints = m_generator->extractControlPointsFromMesh(m_meshData);
+    if (ImGui::SmallButton("Reset")) {
+        Profiler::reset();
+    }
+    ImGui::SameLine();
+    ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f), "GPU times lag a few frames behind");
 
-            if (controlPoints.empty()) {
-                m_lastError = "No control points available. Please select vertices first.";
-                m_isGenerating = false;
-                return;
+    // Chrome trace of every thread, open the file in chrome://tracing or ui.perfetto.dev
+    ImGui::InputText("Trace File", m_tracePath, sizeof(m_tracePath));
+    if (!Profiler::isTracing()) {
+        if (ImGui::Button("Start Trace")) {
+            Profiler::startTrace();
+        }
+    } else {
+        if (ImGui::Button("Stop && Save Trace")) {
+            Profiler::stopTrace();
+            Profiler::writeChromeTrace(m_tracePath);
+        }
+        ImGui::SameLine();
+        ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "Recording...");
+    }
+
+    if (ImGui::BeginTable("##profiler", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerH | ImGuiTableFlags_SizingStretchProp)) {
+        ImGui::TableSetupColumn("Scope");
+        ImGui::TableSetupColumn("");
+        ImGui::TableSetupColumn("Mean ms");
+        ImGui::TableSetupColumn("p95 ms");
+        ImGui::TableSetupColumn("Max ms");
+        ImGui::TableHeadersRow();
+
+        for (const Profiler::ScopeSummary& summary : Profiler::getSummaries()) {
+            const bool gpu = summary.source == Profiler::Source::Gpu;
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", summary.name.c_str());
+            ImGui::TableNextColumn();
+            ImGui::TextColored(gpu ? ImVec4(0.4f, 0.8f, 1.0f, 1.0f) : ImVec4(1.0f, 0.8f, 0.4f, 1.0f), gpu ? "GPU" : "CPU");
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", summary.meanMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", summary.p95Ms);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", summary.maxMs);
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
+
+void Interface::drawMemoryPanel() {
+    if (!m_showMemoryPanel || !m_memoryReportSource) return;
+
+    // Walks every vertex's keyframe map, cheap but not something to do every frame
+    const double now = ImGui::GetTime();
+    if (m_memoryReport.empty() || now - m_memoryReportTime > 0.5) {
+        m_memoryReport = m_memoryReportSource();
+        m_memoryReportTime = now;
+    }
+
+    ImGui::SetNextWindowPos(ImVec2(460.0f, 20.0f), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowSize(ImVec2(460.0f, 380.0f), ImGuiCond_FirstUseEver);
+    ImGui::SetNextWindowBgAlpha(0.85f);
+    if (!ImGui::Begin("Memory", &m_showMemoryPanel)) {
+        ImGui::End();
+        return;
+    }
+
+    const size_t resident = MemoryStats::residentBytes();
+    ImGui::Text("Tracked: %s", MemoryStats::format(MemoryStats::total(m_memoryReport)).c_str());
+    if (resident > 0) {
+        ImGui::SameLine();
+        ImGui::Text("  Process resident: %s", MemoryStats::format(resident).c_str());
+    }
+    ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f), "Solver numbers are from its last factorization");
+
+    ImGui::InputText("Report File", m_memoryReportPath, sizeof(m_memoryReportPath));
+    if (ImGui::Button("Dump Report")) {
+        MemoryStats::writeReport(m_memoryReportSource(), m_memoryReportPath);
+    }
+
+    if (ImGui::BeginTable("##memory", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerH | ImGuiTableFlags_SizingStretchProp)) {
+        ImGui::TableSetupColumn("Item");
+        ImGui::TableSetupColumn("Count");
+        ImGui::TableSetupColumn("Size");
+        ImGui::TableHeadersRow();
+
+        // Entries of a category are collected together, a header row starts each one
+        std::string category;
+        for (const MemoryStats::Entry& entry : m_memoryReport) {
+            if (entry.category != category) {
+                category = entry.category;
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.4f, 1.0f), "%s", category.c_str());
+                ImGui::TableNextColumn();
+                ImGui::TableNextColumn();
+                ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.4f, 1.0f), "%s",
+                                   MemoryStats::format(MemoryStats::totalFor(m_memoryReport, category)).c_str());
             }
 
-            // Generate deformations
-            GenAPI::GenerationResponse response;
-            if (m_animationLength == 1) {
-                response = m_generator->generatePose(controlPoints, std::string(m_promptBuffer));
-            } else {
-                response = m_generator->generateAnimation(controlPoints, std::string(m_promptBuffer), m_animationLength);
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("  %s", entry.name.c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%zu", entry.count);
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", MemoryStats::format(entry.bytes).c_str());
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
+
+void Interface::checkApiConnection() {
+    // One check at a time, typing a URL asks again once the running check is back
+    if (m_apiCheckInFlight) {
+        m_apiRecheck = true;
+        return;
+    }
+    m_apiCheckInFlight = true;
+
+    // The previous check already posted its result, so this join only waits for the thread to exit
+    if (m_apiCheckThread.joinable()) {
+        m_apiCheckThread.join();
+    }
+
+    // A plain thread, not a scheduler task: the render thread runs queued tasks while it waits in
+    // parallelFor, and picking this one up would stall the frame for up to the 5 s curl timeout
+    GenAPI::DeformationGenerator* generator = m_generator.get();
+    m_apiCheckThread = std::thread([this, generator]() {
+        const bool available = generator->isApiAvailable();
+        TaskScheduler::instance().runOnMainThread([this, available]() {
+            m_apiConnected = available;
+            m_apiCheckInFlight = false;
+            if (m_apiRecheck) {
+                m_apiRecheck = false;
+                checkApiConnection();
             }
+        });
+    });
+}
 
-            // print response
-            std::cout << "Generation successful: " << response.success << std::endl;
-            std::cout << "Animation frames generated: " << response.animation_frames.size() << std::endl;
+void Interface::generateDeformations() {
+    if (!m_meshData) {
+        return;
+    }
 
-            if (response.success && !response.animation_frames.empty()) {
-                // Note: We're in a background thread here, but storeAnimationInMesh only
-                // modifies vertex timeframePos maps which should be safe
-                bool stored = m_generator->storeAnimationInMesh(m_meshData, response.animation_frames);
+    m_lastError.clear();
 
-                if (stored) {
-                    std::cout << "Successfully stored " << response.animation_frames.size() << " animation frames!" << std::endl;
-                    std::cout << "Use the timeframe slider to view the animation (1.0, 2.0, 3.0, etc.)" << std::endl;
-                } else {
-                    m_lastError = "Failed to store animation frames";
-                }
-            } else {
-                m_lastError = response.error_message.empty() ? "Generation failed" : response.error_message;
+    // Control points are read here on the render thread, workers only get copies
+    std::vector<GenAPI::ControlPoint> controlPoints = m_generator->extractControlPointsFromMesh(m_meshData);
+    if (controlPoints.empty()) {
+        m_lastError = "No control points available. Please select vertices first.";
+        return;
+    }
+
+    std::vector<std::string> prompts;
+    if (m_promptPerLine) {
+        std::istringstream stream(m_promptBuffer);
+        std::string line;
+        while (std::getline(stream, line)) {
+            if (line.find_first_not_of(" \t\r") != std::string::npos) {
+                prompts.push_back(line);
             }
+        }
+    } else {
+        prompts.push_back(std::string(m_promptBuffer));
+    }
 
-        } catch (const std::exception& e) {
-            m_lastError = "Exception during generation: " + std::string(e.what());
+    for (const std::string& prompt : prompts) {
+        m_queue->submit(GenAPI::GenerationRequest(controlPoints, prompt, m_animationLength));
+    }
+}
+
+void Interface::collectFinishedJobs() {
+    GenAPI::GenerationJobPtr job;
+    while (m_queue->popFinished(job)) {
+        LOG_INFO("Job " << job->id << " finished: " << GenAPI::jobStatusName(job->status)
+                 << ", " << job->response.animation_frames.size() << " frames");
+
+        if (job->status == GenAPI::JobStatus::Done) {
+            if (m_autoApply) {
+                applyJob(*job);
+            }
+        } else if (job->status == GenAPI::JobStatus::Failed) {
+            m_lastError = job->response.error_message.empty() ? "Generation failed" : job->response.error_message;
         }
+    }
+}
+
+void Interface::applyJob(const GenAPI::GenerationJob& job) {
+    if (!m_meshData || job.response.animation_frames.empty()) {
+        return;
+    }
 
-        m_isGenerating = false;
-    }).detach();
+    BakeDynamics dynamics;
+    dynamics.enabled = m_bakeDynamics;
+    dynamics.substeps = m_bakeSubsteps;
+    dynamics.inertia = m_bakeInertia;
+    dynamics.damping = m_bakeDamping;
+    m_meshData->setBakeDynamics(dynamics);
+
+    // The bake runs in the background and is swapped in by Engine::update once it is done
+    if (m_generator->storeAnimationInMesh(m_meshData, job.response.animation_frames)) {
+        m_appliedJobId = job.id;
+        LOG_INFO("Baking " << job.response.animation_frames.size() << " animation frames");
+        LOG_INFO("Use the timeframe slider to view the animation (1.0, 2.0, 3.0, etc.)");
+    } else {
+        m_lastError = "Failed to store animation frames";
+    }
 }
 
 const bool Interface::isHovered() {
@@ -3,13 +3,20 @@
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <functional>
 #include <memory>
 #include <string>
+#include <thread>
+
+#include "Session.hpp"
+#include "Utilities/MemoryStats.hpp"
 
 class MeshData;
 namespace GenAPI {
     class DeformationGenerator;
+    class GenerationQueue;
     struct GenerationResponse;
+    struct GenerationJob;
 }
 
 class Interface {
@@ -36,14 +43,54 @@ private:
     char m_promptBuffer[256];
     int m_animationLength;
     std::string m_apiUrl;
-    bool m_isGenerating;
     std::string m_lastError;
     bool m_apiConnected;
+    bool m_apiCheckInFlight; // Render thread only, cleared by the check's main thread continuation
+    bool m_apiRecheck;
+    std::thread m_apiCheckThread; // isApiAvailable blocks for seconds, it must stay off the scheduler's workers
+    bool m_showTaskPanel;
+    bool m_showProfilerPanel; // Also switches the profiler scopes on and off
+    char m_tracePath[256];
+    bool m_showMemoryPanel;
+    char m_memoryReportPath[256];
+    std::function<MemoryStats::Report()> m_memoryReportSource;
+    MemoryStats::Report m_memoryReport; // Last collected, refreshed a few times per second while shown
+    double m_memoryReportTime;
+
+    // Generation queue state
+    std::unique_ptr<GenAPI::GenerationQueue> m_queue;
+    bool m_promptPerLine;  // Submit every line of the prompt box as its own job
+    bool m_autoApply;      // Apply a job to the mesh as soon as it finishes
+    bool m_bakeDynamics;   // Secondary motion, see BakeDynamics
+    int m_bakeSubsteps;
+    float m_bakeInertia;
+    float m_bakeDamping;
+    int m_appliedJobId;
     
-    // ARAP all frames processing state
-    bool m_processingAllFrames;
-    int m_currentProcessingFrame;
-    int m_totalFramesToProcess;
+    bool m_solveAllFrames; // ARAP on every timeframe, one-shot like m_computeDeformedPos
+
+    int m_deformer;             // Deformer
+    bool m_livePreview;         // Laplacian solve on every drag step, no button press needed
+
+    // ArapSettings of live solves
+    int m_arapMaxIterations;
+    float m_arapTolerance;      // 0 = off
+    float m_arapTimeBudgetMs;   // 0 = off
+    bool m_arapMultilevel;
+    int m_arapFineIterations;
+
+    // Region-of-interest ARAP, see RoiOptions
+    bool m_roiEnabled;
+    bool m_roiFromSelection; // Selected triangles instead of the radius around the moved handles
+    float m_roiRadius;
+
+    // Redraw scheduling
+    bool m_idleMode;                // Only redraw on input, finished work or playback
+    bool m_playing;
+    int m_playbackFps;              // Frame budget while playing
+    float m_playbackSpeed;          // Timeframes per second
+    float m_pendingPlaybackSeconds;
+    float m_frameMs;
 public:
     Interface(GLFWwindow* window, int screen_width, int screen_height);
     ~Interface();
@@ -51,12 +98,23 @@ public:
     void resize(int width, int height);
     void draw();
     void setMeshData(MeshData* meshData) { m_meshData = meshData; }
+    void setWakeCallback(const std::function<void()>& callback); // Called from workers when a job finishes
+    void setMemoryReportSource(const std::function<MemoryStats::Report()>& source) { m_memoryReportSource = source; }
+    void setLayoutPersistence(bool enabled); // Off for recorded sessions, every run starts from the default layout
+    void detachInputCallbacks(); // Stop ImGui from reading live input, replayed events go through replayEvent
+    void replayEvent(const SessionEvent& event); // Through ImGui's GLFW backend handlers
     
 private:
     void drawVertexPanel();
     void drawGenerationPanel();
+    void drawJobList();
+    void drawTaskPanel();
+    void drawProfilerPanel();
+    void drawMemoryPanel();
     void checkApiConnection();
     void generateDeformations();
+    void collectFinishedJobs();
+    void applyJob(const GenAPI::GenerationJob& job);
 
 public:
     enum SelectionMode{
@@ -66,6 +124,12 @@ public:
         AxisDebug   = 0x3
     };
 
+    enum Deformer{
+        ARAP        = 0x0,
+        Laplacian   = 0x1,
+        Skinning    = 0x2   // Preview only, blends precomputed handle weights on the GPU
+    };
+
 private:
     bool m_wireframe;
     SelectionMode m_selectionMode;
@@ -74,6 +138,17 @@ public:
     const SelectionMode getSelectionMode() { return m_selectionMode; }
     const int getVisualizeMode(){ return m_visualizeMode; }
     const bool getCompute() { return m_computeDeformedPos; }
+    const bool getSolveAllFrames() { return m_solveAllFrames; }
+    const Deformer getDeformer() { return static_cast<Deformer>(m_deformer); }
+    const bool getLivePreview() { return m_livePreview && m_deformer == Laplacian; }
+    const int getArapMaxIterations() { return m_arapMaxIterations; }
+    const float getArapTolerance() { return m_arapTolerance; }
+    const float getArapTimeBudgetMs() { return m_arapTimeBudgetMs; }
+    const bool getArapMultilevel() { return m_arapMultilevel; }
+    const int getArapFineIterations() { return m_arapFineIterations; }
+    const bool getRoiEnabled() { return m_roiEnabled; }
+    const bool getRoiFromSelection() { return m_roiFromSelection; }
+    const float getRoiRadius() { return m_roiRadius; }
 
     const bool getDoRefresh() { return doRefresh; }
     const bool getSetTimeFrame() { return safeTimeframe; }
@@ -83,6 +158,13 @@ public:
     const bool isHovered();
 
     void setBuffer(char * b) { buffer = b; }
+
+    const bool isIdleMode() { return m_idleMode; }
+    const bool isAnimating() { return m_playing; }
+    const bool hasBackgroundWork();
+    const int getPlaybackFps() { return m_playbackFps; }
+    void advancePlayback(float seconds) { m_pendingPlaybackSeconds += seconds; }
+    void setFrameTime(float ms) { m_frameMs = ms; }
 };
 
 #endif // INTERFACE_HPP
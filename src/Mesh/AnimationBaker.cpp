@@ -0,0 +1,130 @@
+#include "AnimationBaker.hpp"
+#include "../Utilities/Parallel.hpp"
+#include "../Utilities/Profiler.hpp"
+#include "../Utilities/Logger.hpp"
+
+#include <igl/arap.h>
+#include <igl/cotmatrix.h>
+#include <igl/massmatrix.h>
+#include <algorithm>
+#include <cmath>
+
+Eigen::MatrixXd AnimationBaker::applyDeltas(const Eigen::MatrixXd& basePositions, const GenAPI::AnimationFrame& frame) {
+    Eigen::MatrixXd positions = basePositions;
+    for (const auto& pair : frame) {
+        const int vertexId = pair.first;
+        if (vertexId < 0 || vertexId >= positions.rows()) continue;
+
+        const GenAPI::DeformationDelta& delta = pair.second;
+        positions.row(vertexId) += Eigen::RowVector3d(delta.delta_x, delta.delta_y, delta.delta_z);
+    }
+    return positions;
+}
+
+std::shared_ptr<BakedAnimation> AnimationBaker::bake(const BakeInput& input, const GenAPI::AnimationSequence& frames) {
+    PROFILE_SCOPE("Bake animation");
+
+    std::shared_ptr<BakedAnimation> baked = std::make_shared<BakedAnimation>();
+    baked->frames = frames;
+    baked->basePositions = input.basePositions;
+    baked->framePositions.resize(frames.size());
+
+    // Without handles there is nothing to solve for, the deltas are the pose
+    if (input.handles.size() == 0) {
+        Parallel::forEach(0, static_cast<int>(frames.size()), [&](int i) {
+            baked->framePositions[i] = applyDeltas(input.basePositions, frames[i]);
+        }, 1, "bake frames");
+        return baked;
+    }
+
+    if (input.dynamics.enabled) {
+        bakeDynamics(input, frames, *baked);
+        LOG_INFO("Baked " << frames.size() << " animation frames with dynamics, " <<
+                 input.dynamics.substeps << " substeps each");
+        return baked;
+    }
+
+    // The handle set is the same for every frame, so one factorization serves the whole sequence
+    igl::ARAPData arapData;
+    arapData.with_dynamics = false;
+    {
+        PROFILE_SCOPE("arap_precomputation");
+        igl::arap_precomputation(input.restPositions, input.faces, input.restPositions.cols(), input.handles, arapData);
+    }
+
+    // Frames only depend on the base pose, not on each other, so they are solved in parallel.
+    // arap_solve takes the data by non-const reference but only writes it (data.vel) with dynamics on,
+    // so the chunks share the factorization. ARAPData could not be copied anyway, its Eigen solvers aren't copyable.
+    const int frameCount = static_cast<int>(frames.size());
+    const int perThread = (frameCount + Parallel::workerCount() - 1) / Parallel::workerCount();
+    Parallel::forChunks(0, frameCount, [&](int chunkBegin, int chunkEnd) {
+        Eigen::MatrixXd bc(input.handles.size(), 3);
+
+        for (int i = chunkBegin; i < chunkEnd; ++i) {
+            Eigen::MatrixXd targets = applyDeltas(input.basePositions, frames[i]);
+            for (int j = 0; j < input.handles.size(); ++j) {
+                bc.row(j) = targets.row(input.handles(j));
+            }
+
+            Eigen::MatrixXd deformed = input.restPositions;
+            PROFILE_SCOPE("arap_solve");
+            igl::arap_solve(bc, arapData, deformed);
+            baked->framePositions[i] = deformed;
+        }
+    }, perThread, "bake frames");
+
+    LOG_INFO("Baked " << frames.size() << " animation frames");
+    return baked;
+}
+
+void AnimationBaker::bakeDynamics(const BakeInput& input, const GenAPI::AnimationSequence& frames, BakedAnimation& baked) {
+    const BakeDynamics& dynamics = input.dynamics;
+    const int substeps = std::max(1, dynamics.substeps);
+
+    // igl adds M / ym to the ARAP system. Scaling ym by the ratio of the cotangent and mass matrix traces
+    // keeps inertia meaning the same on a dense or a large mesh as on a small coarse one.
+    igl::ARAPData arapData;
+    arapData.with_dynamics = true;
+    arapData.h = dynamics.frameSeconds / substeps;
+    arapData.max_iter = std::max(1, dynamics.iterations);
+    {
+        PROFILE_SCOPE("arap_precomputation (dynamics)");
+        Eigen::SparseMatrix<double> L, M;
+        igl::cotmatrix(input.restPositions, input.faces, L);
+        igl::massmatrix(input.restPositions, input.faces, igl::MASSMATRIX_TYPE_VORONOI, M);
+        const double stiffness = -L.diagonal().sum();
+        const double mass = M.diagonal().sum();
+        arapData.ym = stiffness > 0.0 ? mass / (std::max(dynamics.inertia, 1e-6) * stiffness) : 1.0;
+
+        igl::arap_precomputation(input.restPositions, input.faces, input.restPositions.cols(), input.handles, arapData);
+    }
+    arapData.f_ext = Eigen::MatrixXd::Zero(input.restPositions.rows(), input.restPositions.cols());
+    arapData.vel = Eigen::MatrixXd::Zero(input.restPositions.rows(), input.restPositions.cols()); // At rest in the base pose
+
+    // Damping is given per frame, so changing the substeps does not change how quickly the motion settles
+    const double keep = std::pow(1.0 - std::min(std::max(dynamics.damping, 0.0), 1.0), 1.0 / substeps);
+
+    Eigen::MatrixXd pose = input.basePositions;
+    Eigen::MatrixXd previous(input.handles.size(), 3), next(input.handles.size(), 3);
+    for (int j = 0; j < input.handles.size(); ++j) {
+        previous.row(j) = input.basePositions.row(input.handles(j));
+    }
+
+    for (size_t i = 0; i < frames.size(); ++i) {
+        const Eigen::MatrixXd targets = applyDeltas(input.basePositions, frames[i]);
+        for (int j = 0; j < input.handles.size(); ++j) {
+            next.row(j) = targets.row(input.handles(j));
+        }
+
+        // Each arap_solve is one implicit time step, it advances data.vel
+        for (int step = 1; step <= substeps; ++step) {
+            PROFILE_SCOPE("arap_solve (dynamics)");
+            const double t = static_cast<double>(step) / substeps;
+            const Eigen::MatrixXd bc = (1.0 - t) * previous + t * next;
+            igl::arap_solve(bc, arapData, pose);
+            arapData.vel *= keep;
+        }
+        baked.framePositions[i] = pose;
+        previous.swap(next);
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef ANIMATION_BAKER_HPP
+#define ANIMATION_BAKER_HPP
+
+#include <Eigen/Dense>
+#include <memory>
+#include <vector>
+
+#include "../GenAPI/GenAPI.hpp"
+
+// Secondary motion: the frames are integrated in order with igl's implicit ARAP dynamics instead of being
+// solved one by one, so the mesh lags behind and overshoots the handles.
+struct BakeDynamics {
+    bool enabled = false;
+    int substeps = 4;               // Time steps per generated frame, handle targets are interpolated in between
+    double frameSeconds = 1.0 / 24.0;
+    double inertia = 0.1;           // Mass term relative to the ARAP stiffness, independent of mesh scale and density
+    double damping = 0.2;           // Fraction of the velocity lost per frame
+    int iterations = 2;             // Local-global iterations per substep
+};
+
+// Everything the bake needs, copied out of MeshData on the render thread.
+// The baker never touches MeshData itself so it can run on any thread.
+struct BakeInput {
+    Eigen::MatrixXd restPositions; // ARAP rest pose (MeshData::m_V)
+    Eigen::MatrixXi faces;
+    Eigen::MatrixXd basePositions; // Pose the deltas are applied to
+    Eigen::VectorXi handles;       // Constrained vertices
+    BakeDynamics dynamics;
+};
+
+// Result of a bake, framePositions[i] is the pose at timeframe i + 1
+struct BakedAnimation {
+    GenAPI::AnimationSequence frames;
+    Eigen::MatrixXd basePositions;
+    std::vector<Eigen::MatrixXd> framePositions;
+};
+
+class AnimationBaker {
+public:
+    static std::shared_ptr<BakedAnimation> bake(const BakeInput& input, const GenAPI::AnimationSequence& frames);
+
+    // Base positions with the frame's deltas applied, without any solve
+    static Eigen::MatrixXd applyDeltas(const Eigen::MatrixXd& basePositions, const GenAPI::AnimationFrame& frame);
+
+private:
+    // Frames depend on the ones before, so this runs sequentially on one factorization
+    static void bakeDynamics(const BakeInput& input, const GenAPI::AnimationSequence& frames, BakedAnimation& baked);
+};
+
+#endif // ANIMATION_BAKER_HPP
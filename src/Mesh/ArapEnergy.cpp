@@ -0,0 +1,67 @@
+#include "ArapEnergy.hpp"
+#include "../Utilities/Parallel.hpp"
+
+namespace {
+    const int kMinChunk = 2048;
+}
+
+ArapEnergy::ArapEnergy(const Eigen::MatrixXd& rest, const Eigen::MatrixXi& faces)
+    : m_rest(rest), m_faces(faces), m_weights(faces.rows(), 3)
+{
+    for (int f = 0; f < m_faces.rows(); ++f) {
+        for (int k = 0; k < 3; ++k) {
+            const Eigen::Vector3d p = m_rest.row(m_faces(f, k)).transpose();
+            const Eigen::Vector3d a = m_rest.row(m_faces(f, (k + 1) % 3)).transpose() - p;
+            const Eigen::Vector3d b = m_rest.row(m_faces(f, (k + 2) % 3)).transpose() - p;
+            const double sine = a.cross(b).norm();
+            m_weights(f, k) = sine > 1e-12 ? 0.5 * a.dot(b) / sine : 0.0; // Degenerate faces drop out
+        }
+    }
+}
+
+void ArapEnergy::fitRotations(const Eigen::MatrixXd& deformed, std::vector<Eigen::Matrix3d>& rotations) const {
+    // Covariance of rest and deformed edges over the faces around each vertex
+    std::vector<Eigen::Matrix3d> covariance(m_rest.rows(), Eigen::Matrix3d::Zero());
+    for (int f = 0; f < m_faces.rows(); ++f) {
+        Eigen::Matrix3d faceCovariance = Eigen::Matrix3d::Zero();
+        for (int k = 0; k < 3; ++k) {
+            const int i = m_faces(f, (k + 1) % 3), j = m_faces(f, (k + 2) % 3);
+            const Eigen::Vector3d restEdge = (m_rest.row(i) - m_rest.row(j)).transpose();
+            const Eigen::Vector3d deformedEdge = (deformed.row(i) - deformed.row(j)).transpose();
+            faceCovariance += m_weights(f, k) * restEdge * deformedEdge.transpose();
+        }
+        for (int k = 0; k < 3; ++k) {
+            covariance[m_faces(f, k)] += faceCovariance;
+        }
+    }
+
+    rotations.resize(m_rest.rows());
+    Parallel::forEach(0, static_cast<int>(m_rest.rows()), [&](int i) {
+        Eigen::JacobiSVD<Eigen::Matrix3d> svd(covariance[i], Eigen::ComputeFullU | Eigen::ComputeFullV);
+        Eigen::Matrix3d u = svd.matrixU();
+        Eigen::Matrix3d rotation = svd.matrixV() * u.transpose();
+        if (rotation.determinant() < 0.0) {
+            u.col(2) *= -1.0; // Reflection, flip the axis of the smallest singular value
+            rotation = svd.matrixV() * u.transpose();
+        }
+        rotations[i] = rotation;
+    }, kMinChunk, "arap rotations");
+}
+
+double ArapEnergy::evaluate(const Eigen::MatrixXd& deformed) const {
+    std::vector<Eigen::Matrix3d> rotations;
+    fitRotations(deformed, rotations);
+
+    double energy = 0.0;
+    for (int f = 0; f < m_faces.rows(); ++f) {
+        for (int k = 0; k < 3; ++k) {
+            const int i = m_faces(f, (k + 1) % 3), j = m_faces(f, (k + 2) % 3);
+            const Eigen::Vector3d restEdge = (m_rest.row(i) - m_rest.row(j)).transpose();
+            const Eigen::Vector3d deformedEdge = (deformed.row(i) - deformed.row(j)).transpose();
+            for (int c = 0; c < 3; ++c) {
+                energy += m_weights(f, k) * (deformedEdge - rotations[m_faces(f, c)] * restEdge).squaredNorm();
+            }
+        }
+    }
+    return energy;
+}
@@ -0,0 +1,28 @@
+#ifndef ARAP_ENERGY_HPP
+#define ARAP_ENERGY_HPP
+
+#include <Eigen/Dense>
+#include <vector>
+
+// The energy igl::arap_solve minimizes on triangle meshes (spokes and rims): every vertex gets the
+// rotation that best fits the edges of its incident faces, weighted by half cotangents of the rest pose.
+// igl does not report it, this evaluates it for a given pose so solves can be compared and stopped.
+class ArapEnergy {
+private:
+    Eigen::MatrixXd m_rest;
+    Eigen::MatrixXi m_faces;
+    Eigen::MatrixXd m_weights; // Per face, half cotangent of the angle opposite edge k (vertices k + 1 and k + 2)
+
+public:
+    ArapEnergy(const Eigen::MatrixXd& rest, const Eigen::MatrixXi& faces);
+
+    double evaluate(const Eigen::MatrixXd& deformed) const;
+
+    // Best fit rotation per vertex, the local step of the solve
+    void fitRotations(const Eigen::MatrixXd& deformed, std::vector<Eigen::Matrix3d>& rotations) const;
+
+    const Eigen::MatrixXd& getRest() const { return m_rest; }
+    const Eigen::MatrixXi& getFaces() const { return m_faces; }
+};
+
+#endif // ARAP_ENERGY_HPP
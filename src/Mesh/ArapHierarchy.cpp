@@ -0,0 +1,263 @@
+#include "ArapHierarchy.hpp"
+#include "../Utilities/Profiler.hpp"
+#include "../Utilities/Logger.hpp"
+#include "../Utilities/TaskScheduler.hpp"
+
+#include <igl/decimate.h>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <queue>
+
+ArapHierarchy::ArapHierarchy(const Eigen::MatrixXd& rest, const Eigen::MatrixXi& faces, int coarsestFaces)
+    : m_hasHandles(false)
+{
+    PROFILE_SCOPE("Build ARAP hierarchy");
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point start = Clock::now();
+
+    // Every level is decimated from the one above, so the decimations form a chain. A level's energy and the
+    // seeds that map it onto the next coarser level only need those two levels, they run next to the decimations
+    // that follow. Slots are made for kMaxLevels, a decimation that isn't needed or fails leaves the rest empty.
+    std::vector<Level> levels(kMaxLevels);
+    std::vector<char> built(kMaxLevels, 0);
+    std::vector<Eigen::VectorXi> birthVertices(kMaxLevels); // I of igl::decimate, per coarse level
+    levels[0].rest = rest;
+    levels[0].faces = faces;
+    built[0] = 1;
+
+    TaskGraph graph;
+    std::vector<int> decimateNodes(kMaxLevels, -1);
+    for (int l = 1; l < kMaxLevels; ++l) {
+        decimateNodes[l] = graph.add("ARAP hierarchy decimate", [&, l]() {
+            const Level& finer = levels[l - 1];
+            if (!built[l - 1] || finer.faces.rows() / 4 < coarsestFaces) return;
+
+            // Shortest edge first, collapsed to the midpoint. I maps every kept vertex to the finer one it started as
+            Level& coarse = levels[l];
+            Eigen::VectorXi birthFaces;
+            if (!igl::decimate(finer.rest, finer.faces, finer.faces.rows() / 4, coarse.rest, coarse.faces, birthFaces, birthVertices[l])) {
+                LOG_WARN("ARAP hierarchy: decimation failed below " << finer.faces.rows() << " faces, stopping there");
+                return;
+            }
+            built[l] = 1;
+        });
+        if (l > 1) graph.precede(decimateNodes[l - 1], decimateNodes[l]);
+    }
+    for (int l = 0; l < kMaxLevels; ++l) {
+        const int energy = graph.add("ARAP hierarchy energy", [&, l]() {
+            if (built[l]) levels[l].energy.reset(new ArapEnergy(levels[l].rest, levels[l].faces));
+        });
+        if (l > 0) graph.precede(decimateNodes[l], energy);
+
+        if (l + 1 < kMaxLevels) {
+            const int seeds = graph.add("ARAP hierarchy seeds", [&, l]() {
+                if (built[l + 1]) levels[l].parent = nearestSeeds(levels[l], birthVertices[l + 1]);
+            });
+            graph.precede(decimateNodes[l + 1], seeds);
+        }
+    }
+    graph.run();
+
+    for (int l = 0; l < kMaxLevels && built[l]; ++l) {
+        m_levels.push_back(std::move(levels[l]));
+    }
+
+    const double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    std::ostringstream sizes;
+    for (const Level& level : m_levels) sizes << " " << level.rest.rows();
+    LOG_INFO("ARAP hierarchy: " << m_levels.size() << " levels, vertices" << sizes.str() << ", built in " << ms << " ms");
+}
+
+Eigen::VectorXi ArapHierarchy::nearestSeeds(const Level& level, const Eigen::VectorXi& seeds) {
+    // Multi-source Dijkstra over the rest pose edges, every vertex takes the index of the seed that reached it
+    const int count = static_cast<int>(level.rest.rows());
+    std::vector<std::vector<int>> neighbours(count);
+    for (int f = 0; f < level.faces.rows(); ++f) {
+        for (int k = 0; k < 3; ++k) {
+            neighbours[level.faces(f, k)].push_back(level.faces(f, (k + 1) % 3));
+            neighbours[level.faces(f, (k + 1) % 3)].push_back(level.faces(f, k));
+        }
+    }
+
+    Eigen::VectorXi nearest = Eigen::VectorXi::Constant(count, -1);
+    std::vector<double> distance(count, std::numeric_limits<double>::infinity());
+    typedef std::pair<double, int> Item;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+    for (int s = 0; s < seeds.size(); ++s) {
+        distance[seeds(s)] = 0.0;
+        nearest(seeds(s)) = s;
+        queue.push(Item(0.0, seeds(s)));
+    }
+    while (!queue.empty()) {
+        Item item = queue.top();
+        queue.pop();
+        if (item.first > distance[item.second]) continue; // Stale entry
+
+        for (int n : neighbours[item.second]) {
+            const double d = item.first + (level.rest.row(n) - level.rest.row(item.second)).norm();
+            if (d < distance[n]) {
+                distance[n] = d;
+                nearest(n) = nearest(item.second);
+                queue.push(Item(d, n));
+            }
+        }
+    }
+    return nearest;
+}
+
+bool ArapHierarchy::setHandles(const Eigen::VectorXi& handles) {
+    Level& full = m_levels[0];
+    if (m_hasHandles && full.handles.size() == handles.size() && full.handles == handles) {
+        return false;
+    }
+    PROFILE_SCOPE("arap_precomputation (hierarchy)");
+    full.handles = handles;
+    m_hasHandles = true;
+
+    for (size_t l = 0; l + 1 < m_levels.size(); ++l) {
+        Level& finer = m_levels[l];
+        Level& coarser = m_levels[l + 1];
+
+        // Handles that land on the same coarse vertex share it, their targets are averaged in solve
+        std::vector<int> slotOf(coarser.rest.rows(), -1);
+        std::vector<int> coarseHandles;
+        finer.handleSlots.assign(finer.handles.size(), -1);
+        for (int i = 0; i < finer.handles.size(); ++i) {
+            const int c = finer.parent(finer.handles(i));
+            if (c < 0) continue; // Part of the mesh the decimation dropped
+            if (slotOf[c] < 0) {
+                slotOf[c] = static_cast<int>(coarseHandles.size());
+                coarseHandles.push_back(c);
+            }
+            finer.handleSlots[i] = slotOf[c];
+        }
+        coarser.handles = Eigen::Map<Eigen::VectorXi>(coarseHandles.data(), coarseHandles.size());
+
+        coarser.data.reset(new igl::ARAPData());
+        coarser.data->with_dynamics = false;
+        igl::arap_precomputation(coarser.rest, coarser.faces, coarser.rest.cols(), coarser.handles, *coarser.data);
+    }
+    return true;
+}
+
+std::vector<Eigen::MatrixXd> ArapHierarchy::levelTargets(const Eigen::MatrixXd& targets) const {
+    // Each coarse handle gets the mean displacement of the handles above it
+    const int levels = getLevelCount();
+    std::vector<Eigen::MatrixXd> result(levels);
+    result[0] = targets;
+    for (int l = 0; l + 1 < levels; ++l) {
+        const Level& finer = m_levels[l];
+        const Level& coarser = m_levels[l + 1];
+        Eigen::MatrixXd sum = Eigen::MatrixXd::Zero(coarser.handles.size(), targets.cols());
+        Eigen::VectorXd count = Eigen::VectorXd::Zero(coarser.handles.size());
+        for (int i = 0; i < finer.handles.size(); ++i) {
+            const int slot = finer.handleSlots[i];
+            if (slot < 0) continue;
+            sum.row(slot) += result[l].row(i) - finer.rest.row(finer.handles(i)) + coarser.rest.row(coarser.handles(slot));
+            count(slot) += 1.0;
+        }
+        result[l + 1] = sum.array().colwise() / count.array();
+    }
+    return result;
+}
+
+void ArapHierarchy::prolongate(int level, const Eigen::MatrixXd& coarsePose, Eigen::MatrixXd& pose) const {
+    // Every vertex follows its coarse vertex, turned by that vertex's rotation
+    const Level& finer = m_levels[level];
+    const Level& coarser = m_levels[level + 1];
+    std::vector<Eigen::Matrix3d> rotations;
+    coarser.energy->fitRotations(coarsePose, rotations);
+
+    pose = finer.rest;
+    for (int v = 0; v < pose.rows(); ++v) {
+        const int c = finer.parent(v);
+        if (c < 0) continue;
+        const Eigen::Vector3d offset = (finer.rest.row(v) - coarser.rest.row(c)).transpose();
+        pose.row(v) = coarsePose.row(c) + (rotations[c] * offset).transpose();
+    }
+}
+
+void ArapHierarchy::solveCoarse(const Eigen::MatrixXd& targets, int fineIterations, Eigen::MatrixXd& pose,
+                                std::vector<ArapLevelReport>* report) {
+    typedef std::chrono::steady_clock Clock;
+    const int levels = getLevelCount();
+    const std::vector<Eigen::MatrixXd> targetsPerLevel = levelTargets(targets);
+
+    if (report) report->clear();
+    pose = m_levels.back().rest;
+    for (int l = levels - 1; l >= 1; --l) {
+        PROFILE_SCOPE("arap_solve (level)");
+        const Clock::time_point start = Clock::now();
+        Level& level = m_levels[l];
+
+        if (l + 1 < levels) {
+            Eigen::MatrixXd coarsePose;
+            coarsePose.swap(pose);
+            prolongate(l, coarsePose, pose);
+        }
+
+        // The coarsest level runs to igl's own iteration count, it is cheap
+        igl::ARAPData& data = *level.data;
+        const int maxIter = data.max_iter;
+        if (l + 1 < levels) data.max_iter = fineIterations;
+        const int iterations = data.max_iter;
+        igl::arap_solve(targetsPerLevel[l], data, pose);
+        data.max_iter = maxIter;
+
+        if (report) {
+            ArapLevelReport levelReport;
+            levelReport.vertices = static_cast<int>(level.rest.rows());
+            levelReport.iterations = iterations;
+            levelReport.ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            levelReport.energy = level.energy->evaluate(pose);
+            report->push_back(levelReport);
+        }
+    }
+}
+
+void ArapHierarchy::initialGuess(const Eigen::MatrixXd& targets, int fineIterations, Eigen::MatrixXd& guess,
+                                 std::vector<ArapLevelReport>* report) {
+    if (getLevelCount() == 1) {
+        guess = m_levels[0].rest;
+        if (report) report->clear();
+        return;
+    }
+    Eigen::MatrixXd coarsePose;
+    solveCoarse(targets, fineIterations, coarsePose, report);
+    prolongate(0, coarsePose, guess);
+}
+
+void ArapHierarchy::solve(const Eigen::MatrixXd& targets, igl::ARAPData& fine, int fineIterations, Eigen::MatrixXd& deformed,
+                          std::vector<ArapLevelReport>* report) {
+    typedef std::chrono::steady_clock Clock;
+    Eigen::MatrixXd coarsePose;
+    if (getLevelCount() > 1) {
+        solveCoarse(targets, fineIterations, coarsePose, report);
+    } else if (report) {
+        report->clear();
+    }
+
+    PROFILE_SCOPE("arap_solve (level)");
+    const Clock::time_point start = Clock::now();
+    if (getLevelCount() > 1) {
+        prolongate(0, coarsePose, deformed);
+    } else {
+        deformed = m_levels[0].rest;
+    }
+
+    const int maxIter = fine.max_iter;
+    if (getLevelCount() > 1) fine.max_iter = fineIterations;
+    const int iterations = fine.max_iter;
+    igl::arap_solve(targets, fine, deformed);
+    fine.max_iter = maxIter;
+
+    if (report) {
+        ArapLevelReport levelReport;
+        levelReport.vertices = getVertexCount(0);
+        levelReport.iterations = iterations;
+        levelReport.ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        levelReport.energy = m_levels[0].energy->evaluate(deformed);
+        report->push_back(levelReport);
+    }
+}
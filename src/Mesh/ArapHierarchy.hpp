@@ -0,0 +1,69 @@
+#ifndef ARAP_HIERARCHY_HPP
+#define ARAP_HIERARCHY_HPP
+
+#include <Eigen/Dense>
+#include <igl/arap.h>
+#include <memory>
+#include <vector>
+
+#include "ArapEnergy.hpp"
+
+// One level of a hierarchical solve, reported coarsest first
+struct ArapLevelReport {
+    int vertices = 0;
+    int iterations = 0;
+    double ms = 0.0;
+    double energy = 0.0; // After this level's iterations, on this level's mesh
+};
+
+// Coarse-to-fine ARAP for dense meshes. Built once from the rest pose, every level is the one above
+// decimated by edge collapses to a quarter of its faces. A solve converges on the coarsest level, carries
+// the pose up one level at a time through the best fit rotations of the coarse vertices, and only runs a
+// few iterations on each finer level starting from that guess.
+class ArapHierarchy {
+private:
+    struct Level {
+        Eigen::MatrixXd rest;
+        Eigen::MatrixXi faces;
+        Eigen::VectorXi parent;         // Per vertex, the nearest vertex on the next coarser level, -1 if none
+        Eigen::VectorXi handles;        // This level's share of the handle set
+        std::vector<int> handleSlots;   // Per handle, the coarser level's handle it is averaged into
+        std::unique_ptr<ArapEnergy> energy;
+        std::unique_ptr<igl::ARAPData> data; // Coarse levels only, the full mesh is factorized by the caller
+    };
+
+    std::vector<Level> m_levels; // Full mesh first
+    bool m_hasHandles;
+
+    static Eigen::VectorXi nearestSeeds(const Level& level, const Eigen::VectorXi& seeds);
+    std::vector<Eigen::MatrixXd> levelTargets(const Eigen::MatrixXd& targets) const;
+    void prolongate(int level, const Eigen::MatrixXd& coarsePose, Eigen::MatrixXd& pose) const; // From level + 1
+    void solveCoarse(const Eigen::MatrixXd& targets, int fineIterations, Eigen::MatrixXd& pose, // Pose of level 1
+                     std::vector<ArapLevelReport>* report);
+
+public:
+    static const int kCoarsestFaces = 2000;
+    static const int kMaxLevels = 5;
+
+    ArapHierarchy(const Eigen::MatrixXd& rest, const Eigen::MatrixXi& faces, int coarsestFaces = kCoarsestFaces);
+
+    int getLevelCount() const { return static_cast<int>(m_levels.size()); } // Including the full mesh
+    int getVertexCount(int level) const { return static_cast<int>(m_levels[level].rest.rows()); }
+    const igl::ARAPData* getLevelData(int level) const { return m_levels[level].data.get(); }
+    const ArapEnergy& getEnergy(int level) const { return *m_levels[level].energy; }
+
+    // Maps the handles down the levels and factorizes the coarse ones. False if it was the same set, nothing to do
+    bool setHandles(const Eigen::VectorXi& handles);
+
+    // Solves every coarse level and carries the result up to the full mesh, for the caller to iterate on
+    void initialGuess(const Eigen::MatrixXd& targets, int fineIterations, Eigen::MatrixXd& guess,
+                      std::vector<ArapLevelReport>* report = nullptr);
+
+    // initialGuess plus fineIterations on the full mesh.
+    // fine is the caller's factorization of the full mesh for the same handles, its max_iter is restored.
+    // With a report every level's energy is evaluated too, which costs about one more iteration per level.
+    void solve(const Eigen::MatrixXd& targets, igl::ARAPData& fine, int fineIterations, Eigen::MatrixXd& deformed,
+               std::vector<ArapLevelReport>* report = nullptr);
+};
+
+#endif // ARAP_HIERARCHY_HPP
@@ -0,0 +1,463 @@
+#include "DeformationSolver.hpp"
+#include "../Utilities/Parallel.hpp"
+#include "../Utilities/Profiler.hpp"
+#include "../Utilities/Logger.hpp"
+#include "../Utilities/TaskScheduler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <future>
+
+namespace {
+    typedef std::chrono::steady_clock Clock;
+
+    double msSince(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // Single arap_solve iterations until the energy stalls, the budget (counted from start) runs out or
+    // maxIterations ran. Without a tolerance or a budget that is one arap_solve call, and the energy is
+    // only evaluated when stats are wanted.
+    void iterateArap(const Eigen::MatrixXd& targets, igl::ARAPData& data, const ArapEnergy& energy, const ArapSettings& settings,
+                     Clock::time_point start, Eigen::MatrixXd& pose, ArapSolveStats* stats) {
+        const int maxIter = data.max_iter;
+        const int iterations = std::max(1, settings.maxIterations);
+
+        if (settings.tolerance <= 0.0 && settings.timeBudgetMs <= 0.0) {
+            data.max_iter = iterations;
+            igl::arap_solve(targets, data, pose);
+            data.max_iter = maxIter;
+            if (stats) {
+                stats->iterations = iterations;
+                stats->energy = energy.evaluate(pose);
+                stats->stop = ArapSolveStats::Stop::Iterations;
+            }
+            return;
+        }
+
+        data.max_iter = 1;
+        ArapSolveStats result;
+        double previous = 0.0;
+        while (result.iterations < iterations) {
+            const Clock::time_point iterationStart = Clock::now();
+            igl::arap_solve(targets, data, pose);
+            result.energy = energy.evaluate(pose);
+            result.iterations++;
+
+            if (settings.tolerance > 0.0 && result.iterations > 1 && previous - result.energy <= settings.tolerance * previous) {
+                result.stop = ArapSolveStats::Stop::Tolerance;
+                break;
+            }
+            previous = result.energy;
+
+            // Assumes the next iteration costs what this one did
+            if (settings.timeBudgetMs > 0.0 && result.iterations < iterations &&
+                msSince(start) + msSince(iterationStart) > settings.timeBudgetMs) {
+                result.stop = ArapSolveStats::Stop::TimeBudget;
+                break;
+            }
+        }
+        data.max_iter = maxIter;
+        if (stats) *stats = result;
+    }
+}
+
+
+DeformationSolver::DeformationSolver(const Eigen::MatrixXd& restPositions, const Eigen::MatrixXi& faces)
+    : m_restPositions(restPositions), m_faces(faces), m_hasFactorization(false),
+      m_stop(false), m_running(false), m_nextVersion(1)
+{
+    updateMemoryUsage();
+    m_thread = std::thread(&DeformationSolver::threadLoop, this);
+}
+
+DeformationSolver::~DeformationSolver() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_condition.notify_all();
+    m_thread.join();
+}
+
+uint64_t DeformationSolver::solve(const Eigen::VectorXi& handles, const Eigen::MatrixXd& targets, const ArapSettings& settings) {
+    Command command;
+    command.type = CommandType::Solve;
+    command.version = m_nextVersion++;
+    command.handles = handles;
+    command.settings = settings;
+    command.targets.push_back(targets);
+
+    const uint64_t version = command.version;
+    enqueue(std::move(command));
+    return version;
+}
+
+uint64_t DeformationSolver::solveRegion(const RegionSolveInput& region, const ArapSettings& settings) {
+    Command command;
+    command.type = CommandType::SolveRegion;
+    command.version = m_nextVersion++;
+    command.region = region;
+    command.settings = settings;
+
+    const uint64_t version = command.version;
+    enqueue(std::move(command));
+    return version;
+}
+
+uint64_t DeformationSolver::solveLaplacian(const Eigen::VectorXi& handles, const Eigen::MatrixXd& targets) {
+    Command command;
+    command.type = CommandType::SolveLaplacian;
+    command.version = m_nextVersion++;
+    command.handles = handles;
+    command.targets.push_back(targets);
+
+    const uint64_t version = command.version;
+    enqueue(std::move(command));
+    return version;
+}
+
+uint64_t DeformationSolver::solveKeyframes(const Eigen::VectorXi& handles, const std::vector<float>& times,
+                                           const std::vector<Eigen::MatrixXd>& targets) {
+    Command command;
+    command.type = CommandType::SolveKeyframes;
+    command.version = m_nextVersion++;
+    command.handles = handles;
+    command.times = times;
+    command.targets = targets;
+
+    const uint64_t version = command.version;
+    enqueue(std::move(command));
+    return version;
+}
+
+void DeformationSolver::bake(const BakeInput& input, const GenAPI::AnimationSequence& frames, const BakeCallback& onBaked) {
+    Command command;
+    command.type = CommandType::Bake;
+    command.version = m_nextVersion++;
+    command.bakeInput = input;
+    command.frames = frames;
+    command.onBaked = onBaked;
+    enqueue(std::move(command));
+}
+
+void DeformationSolver::computeWeights(const Eigen::VectorXi& handles, const WeightsCallback& onWeights) {
+    Command command;
+    command.type = CommandType::ComputeWeights;
+    command.version = m_nextVersion++;
+    command.handles = handles;
+    command.onWeights = onWeights;
+    enqueue(std::move(command));
+}
+
+void DeformationSolver::enqueue(Command&& command) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // Only the newest live pose matters, e.g. while handles are being dragged. A full solve, ARAP or
+        // Laplacian, covers any waiting live solve, a region solve only replaces one over the same vertices.
+        const bool fullPose = command.type == CommandType::Solve || command.type == CommandType::SolveLaplacian;
+        if (fullPose || command.type == CommandType::SolveRegion) {
+            for (auto it = m_commands.begin(); it != m_commands.end();) {
+                const bool superseded = fullPose
+                    ? it->type == CommandType::Solve || it->type == CommandType::SolveLaplacian || it->type == CommandType::SolveRegion
+                    : it->type == CommandType::SolveRegion && it->region.vertices.size() == command.region.vertices.size() &&
+                      it->region.vertices == command.region.vertices;
+                it = superseded ? m_commands.erase(it) : it + 1;
+            }
+        }
+        m_commands.push_back(std::move(command));
+    }
+    m_condition.notify_one();
+}
+
+std::vector<std::shared_ptr<PoseSnapshot>> DeformationSolver::takeSnapshots() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<std::shared_ptr<PoseSnapshot>> snapshots(m_published.begin(), m_published.end());
+    m_published.clear();
+    return snapshots;
+}
+
+bool DeformationSolver::isBusy() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_running || !m_commands.empty();
+}
+
+MemoryStats::Report DeformationSolver::getMemoryUsage() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_memory;
+}
+
+void DeformationSolver::updateMemoryUsage() {
+    using MemoryStats::add;
+    using MemoryStats::bytes;
+
+    MemoryStats::Report report;
+    add(report, "Solver", "Rest positions", m_restPositions.rows(), bytes(m_restPositions));
+    add(report, "Solver", "Faces", m_faces.rows(), bytes(m_faces));
+    auto addArap = [&](const std::string& prefix, const igl::ARAPData& data) {
+        add(report, "Solver", prefix + " K (nonzeros)", data.K.nonZeros(), bytes(data.K));
+        add(report, "Solver", prefix + " M (nonzeros)", data.M.nonZeros(), bytes(data.M));
+        add(report, "Solver", prefix + " CSM (nonzeros)", data.CSM.nonZeros(), bytes(data.CSM));
+        add(report, "Solver", prefix + " G, b", data.G.size() + data.b.size(), bytes(data.G) + bytes(data.b));
+        add(report, "Solver", prefix + " f_ext, vel", data.f_ext.size() + data.vel.size(), bytes(data.f_ext) + bytes(data.vel));
+        add(report, "Solver", prefix + " Auu (nonzeros)", data.solver_data.Auu.nonZeros(), bytes(data.solver_data.Auu));
+        if (data.solver_data.solver_type == igl::min_quad_with_fixed_data<double>::LLT) {
+            // The Cholesky factor is usually the largest piece, it grows with the fill-in of the ordering
+            const auto& factor = data.solver_data.llt.matrixL().nestedExpression();
+            add(report, "Solver", prefix + " Cholesky factor (nonzeros)", factor.nonZeros(), bytes(factor));
+        }
+    };
+    if (m_hasFactorization) {
+        addArap("ARAP", *m_arapData);
+    }
+    if (m_regionData) {
+        addArap("ARAP region", *m_regionData);
+    }
+    if (m_laplacian) {
+        m_laplacian->collectMemoryUsage(report);
+    }
+    if (m_hierarchy) {
+        for (int l = 1; l < m_hierarchy->getLevelCount(); ++l) {
+            if (!m_hierarchy->getLevelData(l)) continue; // Not factorized yet
+            addArap("ARAP level " + std::to_string(l), *m_hierarchy->getLevelData(l));
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_memory.swap(report);
+}
+
+void DeformationSolver::publish(const std::shared_ptr<PoseSnapshot>& snapshot) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // An unread live pose is superseded by a newer one, keyframe results are always kept.
+    // Region results only hold part of the mesh, so they are kept too until a full pose replaces them.
+    if (!snapshot->keyframes.empty() || snapshot->vertices.size() > 0) {
+        m_published.push_back(snapshot);
+        return;
+    }
+    for (auto it = m_published.begin(); it != m_published.end();) {
+        it = (*it)->keyframes.empty() ? m_published.erase(it) : it + 1;
+    }
+    m_published.push_back(snapshot);
+}
+
+void DeformationSolver::threadLoop() {
+    Profiler::setThreadName("solver");
+
+    while (true) {
+        Command command;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_stop || !m_commands.empty(); });
+            if (m_stop) {
+                return;
+            }
+            command = std::move(m_commands.front());
+            m_commands.pop_front();
+            m_running = true;
+        }
+
+        try {
+            execute(command);
+        } catch (const std::exception& e) {
+            LOG_ERROR("Deformation solver command failed: " << e.what());
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running = false;
+        }
+        if (m_publishCallback) {
+            m_publishCallback();
+        }
+    }
+}
+
+void DeformationSolver::execute(Command& command) {
+    switch (command.type) {
+        case CommandType::Solve: {
+            std::shared_ptr<PoseSnapshot> snapshot = std::make_shared<PoseSnapshot>();
+            snapshot->version = command.version;
+            snapshot->positions = solveArap(command.handles, command.targets[0], command.settings, &snapshot->stats);
+            publish(snapshot);
+            break;
+        }
+        case CommandType::SolveRegion: {
+            std::shared_ptr<PoseSnapshot> snapshot = std::make_shared<PoseSnapshot>();
+            snapshot->version = command.version;
+            snapshot->vertices = command.region.vertices;
+            snapshot->positions = solveRegionArap(command.region, command.settings, snapshot->stats);
+            publish(snapshot);
+            break;
+        }
+        case CommandType::SolveLaplacian: {
+            const Clock::time_point start = Clock::now();
+            prepareLaplacian(command.handles);
+
+            std::shared_ptr<PoseSnapshot> snapshot = std::make_shared<PoseSnapshot>();
+            snapshot->version = command.version;
+            snapshot->positions = m_laplacian->solve(command.targets[0]);
+            snapshot->stats.ms = msSince(start);
+            publish(snapshot);
+            break;
+        }
+        case CommandType::SolveKeyframes: {
+            std::shared_ptr<PoseSnapshot> snapshot = std::make_shared<PoseSnapshot>();
+            snapshot->version = command.version;
+            snapshot->keyframeTimes = command.times;
+            snapshot->keyframes.resize(command.targets.size());
+            if (command.targets.empty()) break;
+
+            // Factorize once here, then the keyframes are independent solves like in AnimationBaker
+            snapshot->keyframes[0] = solveArap(command.handles, command.targets[0]);
+
+            const int count = static_cast<int>(command.targets.size());
+            const int perThread = (count - 1 + Parallel::workerCount() - 1) / Parallel::workerCount();
+            Parallel::forChunks(1, count, [&](int chunkBegin, int chunkEnd) {
+                for (int i = chunkBegin; i < chunkEnd; ++i) {
+                    Eigen::MatrixXd deformed = m_restPositions;
+                    PROFILE_SCOPE("arap_solve");
+                    igl::arap_solve(command.targets[i], *m_arapData, deformed); // Read only without dynamics, see AnimationBaker
+                    snapshot->keyframes[i] = deformed;
+                }
+            }, perThread, "keyframe solves");
+            publish(snapshot);
+            break;
+        }
+        case CommandType::ComputeWeights: {
+            // Same factorization as the Laplacian deformer, so switching between the two keeps it.
+            // The callback always runs, with null on failure, like a bake
+            const Clock::time_point start = Clock::now();
+            std::shared_ptr<HandleWeights> weights;
+            try {
+                prepareLaplacian(command.handles);
+                weights = m_laplacian->computeWeights();
+                LOG_INFO("Skinning weights for " << command.handles.size() << " handles in " << msSince(start) << " ms");
+            } catch (const std::exception& e) {
+                LOG_ERROR("Skinning weights failed: " << e.what());
+            }
+            if (command.onWeights) {
+                command.onWeights(weights);
+            }
+            break;
+        }
+        case CommandType::Bake: {
+            // The callback always runs so the caller can account for the bake, with null on failure
+            std::shared_ptr<BakedAnimation> baked;
+            try {
+                baked = AnimationBaker::bake(command.bakeInput, command.frames);
+            } catch (const std::exception& e) {
+                LOG_ERROR("Animation bake failed: " << e.what());
+            }
+            if (command.onBaked) {
+                command.onBaked(baked);
+            }
+            break;
+        }
+    }
+}
+
+void DeformationSolver::prepareLaplacian(const Eigen::VectorXi& handles) {
+    if (!m_laplacian) {
+        m_laplacian.reset(new LaplacianDeformer(m_restPositions, m_faces));
+    }
+    if (m_laplacian->setHandles(handles)) {
+        updateMemoryUsage();
+    }
+}
+
+Eigen::MatrixXd DeformationSolver::solveArap(const Eigen::VectorXi& handles, const Eigen::MatrixXd& targets,
+                                             const ArapSettings& settings, ArapSolveStats* stats) {
+    const Clock::time_point start = Clock::now();
+
+    // The coarse levels are built and factorized on the pool while this thread factorizes the full mesh.
+    // Without handles the coarse levels would have nothing to hold them either.
+    const bool hierarchical = settings.hierarchical && handles.size() > 0;
+    std::future<bool> coarseFactorized;
+    if (hierarchical) {
+        coarseFactorized = TaskScheduler::instance().async("ARAP hierarchy setup", [this, &handles]() {
+            if (!m_hierarchy) {
+                m_hierarchy.reset(new ArapHierarchy(m_restPositions, m_faces));
+            }
+            return m_hierarchy->setHandles(handles);
+        });
+    }
+
+    // The factorization only depends on the handle set, reuse it until the selection changes
+    const bool sameHandles = m_hasFactorization && m_cachedHandles.size() == handles.size() && m_cachedHandles == handles;
+    if (!sameHandles) {
+        PROFILE_SCOPE("arap_precomputation");
+        m_arapData.reset(new igl::ARAPData());
+        m_arapData->with_dynamics = false;
+        igl::arap_precomputation(m_restPositions, m_faces, m_restPositions.cols(), handles, *m_arapData);
+        m_cachedHandles = handles;
+        m_hasFactorization = true;
+    }
+
+    bool refactorized = !sameHandles;
+    if (hierarchical) {
+        TaskScheduler::instance().helpUntil([&coarseFactorized]() {
+            return coarseFactorized.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        });
+        refactorized = coarseFactorized.get() || refactorized;
+    }
+    if (refactorized) {
+        updateMemoryUsage(); // Reads the hierarchy too, only once its task is done
+    }
+
+    Eigen::MatrixXd deformed = m_restPositions;
+    if (hierarchical) {
+        const bool logLevels = Logger::isEnabled(Logger::Level::Debug);
+        std::vector<ArapLevelReport> report;
+        m_hierarchy->initialGuess(targets, settings.fineIterations, deformed, logLevels ? &report : nullptr);
+        for (const ArapLevelReport& level : report) {
+            LOG_DEBUG("ARAP level: " << level.vertices << " vertices, " << level.iterations << " iterations, " <<
+                      level.ms << " ms, energy " << level.energy);
+        }
+    }
+
+    PROFILE_SCOPE("arap_solve");
+    if (!m_energy && (stats || settings.tolerance > 0.0 || settings.timeBudgetMs > 0.0)) {
+        m_energy.reset(new ArapEnergy(m_restPositions, m_faces));
+    }
+    if (m_energy) {
+        iterateArap(targets, *m_arapData, *m_energy, settings, start, deformed, stats);
+    } else {
+        igl::arap_solve(targets, *m_arapData, deformed); // Keyframe solves, igl's own iteration count
+    }
+    if (stats) stats->ms = msSince(start);
+    return deformed;
+}
+
+Eigen::MatrixXd DeformationSolver::solveRegionArap(const RegionSolveInput& region, const ArapSettings& settings,
+                                                   ArapSolveStats& stats) {
+    const Clock::time_point start = Clock::now();
+    Eigen::MatrixXd rest(region.vertices.size(), m_restPositions.cols());
+    for (int i = 0; i < region.vertices.size(); ++i) {
+        rest.row(i) = m_restPositions.row(region.vertices[i]);
+    }
+
+    // Dragging within one region keeps both the vertices and the handles, so this factorizes once per region
+    const bool sameRegion = m_regionData &&
+        m_regionVertices.size() == region.vertices.size() && m_regionVertices == region.vertices &&
+        m_regionHandles.size() == region.handles.size() && m_regionHandles == region.handles;
+    if (!sameRegion) {
+        PROFILE_SCOPE("arap_precomputation (region)");
+        m_regionData.reset(new igl::ARAPData());
+        m_regionData->with_dynamics = false;
+        igl::arap_precomputation(rest, region.faces, rest.cols(), region.handles, *m_regionData);
+        m_regionEnergy.reset(new ArapEnergy(rest, region.faces));
+        m_regionVertices = region.vertices;
+        m_regionHandles = region.handles;
+        updateMemoryUsage();
+    }
+
+    PROFILE_SCOPE("arap_solve (region)");
+    Eigen::MatrixXd deformed = rest;
+    iterateArap(region.targets, *m_regionData, *m_regionEnergy, settings, start, deformed, &stats);
+    stats.ms = msSince(start);
+    return deformed;
+}
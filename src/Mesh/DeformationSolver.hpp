@@ -0,0 +1,156 @@
+#ifndef DEFORMATION_SOLVER_HPP
+#define DEFORMATION_SOLVER_HPP
+
+#include <Eigen/Dense>
+#include <igl/arap.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "AnimationBaker.hpp"
+#include "ArapHierarchy.hpp"
+#include "LaplacianDeformer.hpp"
+#include "../Utilities/MemoryStats.hpp"
+
+// What a live solve did, shown in the Controls panel
+struct ArapSolveStats {
+    enum class Stop {
+        Iterations,     // Ran maxIterations
+        Tolerance,      // The energy stopped going down
+        TimeBudget
+    };
+    int iterations = 0;     // On the mesh that was solved, coarse levels not counted
+    double energy = 0.0;
+    double ms = 0.0;        // Whole solve, including coarse levels and energy evaluations
+    Stop stop = Stop::Iterations;
+};
+
+// Result of a solve, tagged with the version of the command that produced it.
+// A live solve fills positions, a keyframe solve fills keyframeTimes/keyframes instead.
+// A region solve only has the rows of the listed vertices in positions.
+struct PoseSnapshot {
+    uint64_t version = 0;
+    Eigen::MatrixXd positions;
+    Eigen::VectorXi vertices;
+    ArapSolveStats stats; // Live and region solves
+    std::vector<float> keyframeTimes;
+    std::vector<Eigen::MatrixXd> keyframes;
+};
+
+// How a live solve runs, copied into each command
+struct ArapSettings {
+    int maxIterations = 10;     // igl's default
+    double tolerance = 0.0;     // Stop once an iteration lowers the energy by less than this fraction of it, 0 = off
+    double timeBudgetMs = 0.0;  // Stop before an iteration that would not fit any more, 0 = off
+    bool hierarchical = false;  // Start from ArapHierarchy's coarse solve, built on first use
+    int fineIterations = 2;     // Per level between the coarsest and the full mesh
+};
+
+// ARAP on a submesh. Vertices maps local to mesh indices, faces and handles use local indices.
+// The handles are the fixed ring around the region plus the handles inside it.
+struct RegionSolveInput {
+    Eigen::VectorXi vertices;
+    Eigen::MatrixXi faces;
+    Eigen::VectorXi handles;
+    Eigen::MatrixXd targets;
+};
+
+// Owns the ARAP state and runs every solve and bake on its own thread.
+// The render thread only submits commands with copied inputs and picks up the published snapshots,
+// so a long solve never blocks drawing.
+class DeformationSolver {
+public:
+    typedef std::function<void(const std::shared_ptr<BakedAnimation>&)> BakeCallback;
+    typedef std::function<void(const std::shared_ptr<HandleWeights>&)> WeightsCallback;
+
+private:
+    enum class CommandType {
+        Solve,
+        SolveRegion,
+        SolveLaplacian,
+        SolveKeyframes,
+        Bake,
+        ComputeWeights
+    };
+
+    struct Command {
+        CommandType type;
+        uint64_t version;
+        Eigen::VectorXi handles;
+        ArapSettings settings;              // Solve and SolveRegion
+        std::vector<float> times;           // SolveKeyframes only
+        std::vector<Eigen::MatrixXd> targets; // One handle target matrix per solve
+        RegionSolveInput region;            // SolveRegion only
+        BakeInput bakeInput;
+        GenAPI::AnimationSequence frames;
+        BakeCallback onBaked;
+        WeightsCallback onWeights;
+    };
+
+    // Solver thread only
+    Eigen::MatrixXd m_restPositions;
+    Eigen::MatrixXi m_faces;
+    Eigen::VectorXi m_cachedHandles; // Handle set m_arapData was factorized for
+    std::unique_ptr<igl::ARAPData> m_arapData; // Not copyable or assignable (Eigen solvers), replaced per factorization
+    bool m_hasFactorization;
+
+    // Region solves keep their own factorization, so leaving region mode does not refactorize the full mesh
+    Eigen::VectorXi m_regionVertices, m_regionHandles; // Region and handle set m_regionData was factorized for
+    std::unique_ptr<igl::ARAPData> m_regionData;
+    std::unique_ptr<ArapHierarchy> m_hierarchy; // Built on the first hierarchical solve
+    std::unique_ptr<ArapEnergy> m_energy, m_regionEnergy; // Built on the first solve that needs them
+    std::unique_ptr<LaplacianDeformer> m_laplacian; // Built on the first Laplacian solve or weights
+
+    std::thread m_thread;
+    std::deque<Command> m_commands;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stop;
+    bool m_running;
+
+    std::atomic<uint64_t> m_nextVersion;
+    std::deque<std::shared_ptr<PoseSnapshot>> m_published; // Guarded by m_mutex, oldest first
+    std::function<void()> m_publishCallback;
+    MemoryStats::Report m_memory; // Guarded by m_mutex, refreshed by the solver thread after each factorization
+
+    void publish(const std::shared_ptr<PoseSnapshot>& snapshot);
+    void updateMemoryUsage();
+
+    void threadLoop();
+    void execute(Command& command);
+    Eigen::MatrixXd solveArap(const Eigen::VectorXi& handles, const Eigen::MatrixXd& targets,
+                              const ArapSettings& settings = ArapSettings(), ArapSolveStats* stats = nullptr);
+    Eigen::MatrixXd solveRegionArap(const RegionSolveInput& region, const ArapSettings& settings, ArapSolveStats& stats);
+    void prepareLaplacian(const Eigen::VectorXi& handles); // Builds m_laplacian and factorizes it for the handles
+    void enqueue(Command&& command);
+
+public:
+    DeformationSolver(const Eigen::MatrixXd& restPositions, const Eigen::MatrixXi& faces);
+    ~DeformationSolver();
+
+    // Each returns the version its snapshot will carry. A newer live solve replaces one still waiting.
+    uint64_t solve(const Eigen::VectorXi& handles, const Eigen::MatrixXd& targets, const ArapSettings& settings = ArapSettings());
+    uint64_t solveRegion(const RegionSolveInput& region, const ArapSettings& settings = ArapSettings());
+    uint64_t solveLaplacian(const Eigen::VectorXi& handles, const Eigen::MatrixXd& targets); // Preview, see LaplacianDeformer
+    uint64_t solveKeyframes(const Eigen::VectorXi& handles, const std::vector<float>& times,
+                            const std::vector<Eigen::MatrixXd>& targets);
+    void bake(const BakeInput& input, const GenAPI::AnimationSequence& frames, const BakeCallback& onBaked);
+    void computeWeights(const Eigen::VectorXi& handles, const WeightsCallback& onWeights); // Skinning weights, see LaplacianDeformer
+
+    // Render thread, everything published since the last call in version order
+    std::vector<std::shared_ptr<PoseSnapshot>> takeSnapshots();
+
+    bool isBusy();
+    MemoryStats::Report getMemoryUsage(); // Solver state as of the last factorization
+
+    // Called on the solver thread after each command, set before submitting anything
+    void setPublishCallback(const std::function<void()>& callback) { m_publishCallback = callback; }
+};
+
+#endif // DEFORMATION_SOLVER_HPP
@@ -0,0 +1,153 @@
+#include "LaplacianDeformer.hpp"
+#include "../Utilities/Parallel.hpp"
+#include "../Utilities/Profiler.hpp"
+#include "../Utilities/Logger.hpp"
+
+#include <igl/cotmatrix.h>
+#include <igl/massmatrix.h>
+#include <algorithm>
+
+LaplacianDeformer::LaplacianDeformer(const Eigen::MatrixXd& rest, const Eigen::MatrixXi& faces)
+    : m_rest(rest), m_hasHandleSet(false), m_hasFactorization(false)
+{
+    PROFILE_SCOPE("Laplacian precomputation");
+    Eigen::SparseMatrix<double> L, M;
+    igl::cotmatrix(rest, faces, L);
+    igl::massmatrix(rest, faces, igl::MASSMATRIX_TYPE_VORONOI, M);
+
+    // Zero area vertices (unreferenced or fully degenerate) would divide by zero, they get no weight instead
+    Eigen::VectorXd massInverse = M.diagonal();
+    for (int i = 0; i < massInverse.size(); ++i) {
+        massInverse(i) = massInverse(i) > 1e-12 ? 1.0 / massInverse(i) : 0.0;
+    }
+    m_Q = L * massInverse.asDiagonal() * L;
+}
+
+bool LaplacianDeformer::setHandles(const Eigen::VectorXi& handles) {
+    if (m_hasHandleSet && m_handles.size() == handles.size() && m_handles == handles) {
+        return false; // Also after a failed factorization, it would fail again
+    }
+    PROFILE_SCOPE("Laplacian factorization");
+    m_handles = handles;
+    m_hasHandleSet = true;
+    m_hasFactorization = false;
+
+    // Column of every vertex in the free block or the handle block
+    const int count = static_cast<int>(m_rest.rows());
+    std::vector<int> slot(count, -1);
+    for (int i = 0; i < handles.size(); ++i) slot[handles(i)] = i;
+    m_free.clear();
+    std::vector<int> freeSlot(count, -1);
+    for (int v = 0; v < count; ++v) {
+        if (slot[v] >= 0) continue;
+        freeSlot[v] = static_cast<int>(m_free.size());
+        m_free.push_back(v);
+    }
+    if (handles.size() == 0) {
+        return true; // Nothing holds the mesh, only the rest pose is a solution
+    }
+
+    std::vector<Eigen::Triplet<double>> uu, ub;
+    for (int col = 0; col < m_Q.outerSize(); ++col) {
+        for (Eigen::SparseMatrix<double>::InnerIterator it(m_Q, col); it; ++it) {
+            const int row = freeSlot[it.row()];
+            if (row < 0) continue;
+            if (freeSlot[col] >= 0) uu.push_back(Eigen::Triplet<double>(row, freeSlot[col], it.value()));
+            else ub.push_back(Eigen::Triplet<double>(row, slot[col], it.value()));
+        }
+    }
+    Eigen::SparseMatrix<double> Quu(m_free.size(), m_free.size());
+    Quu.setFromTriplets(uu.begin(), uu.end());
+    m_Qub.resize(m_free.size(), handles.size());
+    m_Qub.setFromTriplets(ub.begin(), ub.end());
+
+    m_solver.compute(Quu);
+    if (m_solver.info() != Eigen::Success) {
+        LOG_WARN("Laplacian factorization failed, is every part of the mesh holding a handle?");
+        return true;
+    }
+    m_hasFactorization = true;
+    return true;
+}
+
+Eigen::MatrixXd LaplacianDeformer::solve(const Eigen::MatrixXd& targets) const {
+    Eigen::MatrixXd deformed = m_rest;
+    if (!m_hasFactorization) return deformed;
+
+    PROFILE_SCOPE("Laplacian solve");
+    Eigen::MatrixXd handleDisplacement(m_handles.size(), m_rest.cols());
+    for (int i = 0; i < m_handles.size(); ++i) {
+        handleDisplacement.row(i) = targets.row(i) - m_rest.row(m_handles(i));
+    }
+
+    // Q_uu d_u = -Q_ub d_b, all three coordinates in one back-substitution
+    const Eigen::MatrixXd freeDisplacement = m_solver.solve(-(m_Qub * handleDisplacement));
+    for (size_t i = 0; i < m_free.size(); ++i) {
+        deformed.row(m_free[i]) += freeDisplacement.row(i);
+    }
+    for (int i = 0; i < m_handles.size(); ++i) {
+        deformed.row(m_handles(i)) = targets.row(i);
+    }
+    return deformed;
+}
+
+std::shared_ptr<HandleWeights> LaplacianDeformer::computeWeights() const {
+    const int K = HandleWeights::kInfluences;
+    const int count = static_cast<int>(m_rest.rows());
+    std::shared_ptr<HandleWeights> result = std::make_shared<HandleWeights>();
+    result->handles = m_handles;
+    result->indices = Eigen::MatrixXi::Zero(count, K);
+    result->weights = Eigen::MatrixXf::Zero(count, K);
+    if (!m_hasFactorization) return result;
+
+    PROFILE_SCOPE("Laplacian handle weights");
+    for (int h = 0; h < m_handles.size(); ++h) {
+        result->indices(m_handles(h), 0) = h;
+        result->weights(m_handles(h), 0) = 1.0f;
+    }
+
+    // Column h is the displacement of the free vertices when handle h moves by one and the others stay, the
+    // same system as solve(). Blocks of handles bound the dense right hand side on meshes with many handles.
+    const int kBlock = 32;
+    for (int first = 0; first < m_handles.size(); first += kBlock) {
+        const int columns = std::min(kBlock, static_cast<int>(m_handles.size()) - first);
+        const Eigen::MatrixXd rhs = -Eigen::MatrixXd(m_Qub.middleCols(first, columns));
+        const Eigen::MatrixXd block = m_solver.solve(rhs);
+
+        // Keeps each row's K largest, sorted from the largest down
+        Parallel::forEach(0, static_cast<int>(m_free.size()), [&](int i) {
+            const int v = m_free[i];
+            for (int c = 0; c < columns; ++c) {
+                const float w = static_cast<float>(block(i, c));
+                if (w <= result->weights(v, K - 1)) continue;
+                int slot = K - 1;
+                for (; slot > 0 && result->weights(v, slot - 1) < w; --slot) {
+                    result->weights(v, slot) = result->weights(v, slot - 1);
+                    result->indices(v, slot) = result->indices(v, slot - 1);
+                }
+                result->weights(v, slot) = w;
+                result->indices(v, slot) = first + c;
+            }
+        }, 4096, "handle weights");
+    }
+
+    // Unbounded biharmonic weights dip below zero and overshoot one, the dropped influences leave the rest short.
+    // Negative ones never made it into the rows above, renormalizing restores the partition of unity.
+    for (int v = 0; v < count; ++v) {
+        const float sum = result->weights.row(v).sum();
+        if (sum > 0.0f) result->weights.row(v) /= sum;
+    }
+    return result;
+}
+
+void LaplacianDeformer::collectMemoryUsage(MemoryStats::Report& report) const {
+    using MemoryStats::add;
+    using MemoryStats::bytes;
+
+    add(report, "Solver", "Laplacian Q (nonzeros)", m_Q.nonZeros(), bytes(m_Q));
+    add(report, "Solver", "Laplacian Qub (nonzeros)", m_Qub.nonZeros(), bytes(m_Qub));
+    if (m_hasFactorization) {
+        const auto& factor = m_solver.matrixL().nestedExpression();
+        add(report, "Solver", "Laplacian LDLT factor (nonzeros)", factor.nonZeros(), bytes(factor));
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef LAPLACIAN_DEFORMER_HPP
+#define LAPLACIAN_DEFORMER_HPP
+
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+#include <Eigen/SparseCholesky>
+#include <memory>
+#include <vector>
+
+#include "../Utilities/MemoryStats.hpp"
+
+// Smooth per-vertex handle weights for the linear blend skinning preview, a pose is
+// rest + sum of weight * handle displacement. Only the largest kInfluences per vertex are kept.
+struct HandleWeights {
+    static const int kInfluences = 4;
+    Eigen::VectorXi handles;    // Set the weights are for, indices point into it
+    Eigen::MatrixXi indices;    // Vertices x kInfluences, unused slots are 0 with weight 0
+    Eigen::MatrixXf weights;    // Same shape, rows sum to one, or to zero where no handle reaches
+};
+
+// Laplacian surface editing: the displacement from the rest pose with the least bi-Laplacian energy
+// (L M^-1 L, cotangent L, Voronoi M) that moves the handles onto their targets. The system is linear and
+// only depends on the handle set, so it is factorized once per set and every move is a back-substitution.
+// There are no rotations, large twists shear the surface details, ARAP is still the one to bake with.
+class LaplacianDeformer {
+private:
+    Eigen::MatrixXd m_rest;
+    Eigen::SparseMatrix<double> m_Q;    // L M^-1 L
+    Eigen::SparseMatrix<double> m_Qub;  // Free rows, handle columns
+    Eigen::VectorXi m_handles;          // Set the factorization is for
+    std::vector<int> m_free;            // Vertices that are not handles, in order
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> m_solver; // Free rows and columns of m_Q
+    bool m_hasHandleSet;
+    bool m_hasFactorization;
+
+public:
+    LaplacianDeformer(const Eigen::MatrixXd& rest, const Eigen::MatrixXi& faces);
+
+    // True if it had to factorize, false for the same set. isFactorized is false after a failed factorization,
+    // e.g. a mesh component without any handle
+    bool setHandles(const Eigen::VectorXi& handles);
+    bool isFactorized() const { return m_hasFactorization; }
+
+    Eigen::MatrixXd solve(const Eigen::MatrixXd& targets) const; // One row per handle, in setHandles order
+
+    // Biharmonic weights of the current handle set, one back-substitution per handle
+    std::shared_ptr<HandleWeights> computeWeights() const;
+
+    void collectMemoryUsage(MemoryStats::Report& report) const;
+};
+
+#endif // LAPLACIAN_DEFORMER_HPP
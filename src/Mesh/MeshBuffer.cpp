@@ -1,62 +1,62 @@
 #include "MeshData.hpp"
+#include "../Utilities/Parallel.hpp"
+#include "../Utilities/GpuProfiler.hpp"
+#include "../Utilities/TaskScheduler.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+void MeshData::updateTriangleColor(MeshVisMode mode, float scalar) {
+    // Mode and range are shader uniforms, switching them never touches the buffer
+    if (!isHeadless()) {
+        m_mesh->setVisMode(static_cast<int>(mode));
+        m_mesh->setScalarRange(scalar);
+    }
+
+    if (m_colorDirty & ColorDirtySelection) {
+        refreshTriangleColor();
+    }
+
+    // The scalar field is only uploaded while something displays it
+    if (mode == MeshVisMode::Weight) {
+        ensureGeometryAttributes();
+    }
+    if (mode == MeshVisMode::Weight && (m_colorDirty & (ColorDirtyPositions | ColorDirtyCurvature))) {
+        refreshScalarField();
+    }
+}
+
+void MeshData::refreshTriangleColor() {
+    m_colorDirty &= ~ColorDirtySelection;
+    if (isHeadless()) return;
+
+    PROFILE_SCOPE("Upload colors");
+    PROFILE_GPU_SCOPE("Upload colors");
 
-void MeshData::refreshTriangleColor(MeshVisMode mode, float scalar) {
     // Mesh Color
-    // Data of Mesh: [ X Y Z ] [ NX NY NZ ] [ R G B ]
+    // Data of Mesh: [ X Y Z ] [ NX NY NZ ] [ R G B SEL ] [ S ]
+    // SEL marks selected corners, the shader keeps their color in every visualization mode
     {
         size_t vertCounts = m_selectedTriangles.size() * 3;
         size_t offset = vertCounts * 3 * 2 * sizeof(float); // Skip data of Pos + Norm
-        size_t length = vertCounts * 3 * sizeof(float);
+        size_t length = vertCounts * 4 * sizeof(float);
 
         std::vector<float> colorBuffer;
-        colorBuffer.resize(vertCounts * 3);
+        colorBuffer.resize(vertCounts * 4);
         for (size_t tri_i = 0; tri_i < m_selectedTriangles.size(); ++tri_i) {
-            const Triangle& tri = m_triangles[tri_i];
-            HalfEdge* he = tri.he->prev;
+            const bool selected = m_selectedTriangles[tri_i];
+            const Eigen::Vector3f& color = selected ? m_meshSelectColor : m_meshColor;
             for (int j = 0; j < 3; ++j) {
                 size_t i = tri_i * 3 + j;
-                int vidx = he->vertex->index;
-                switch(mode) {
-                    case Normals:
-                        colorBuffer[i * 3 + 0] = static_cast<float>(m_vertices[vidx].normal.x());
-                        colorBuffer[i * 3 + 1] = static_cast<float>(m_vertices[vidx].normal.y());
-                        colorBuffer[i * 3 + 2] = static_cast<float>(m_vertices[vidx].normal.z());
-                        break;
-                    case Weight:
-                        {
-                            Eigen::Vector3d Hvec = m_vertices[vidx].meanCurvatureNormal;
-                            double sign = Hvec.dot(m_vertices[vidx].normal) >= 0 ? 1.0 : -1.0;
-                            double signedH = sign * Hvec.norm();
-
-                            // Normalize by max range
-                            float normalized = static_cast<float>(signedH / scalar);  // Now in [-1, 1]
-                            normalized = std::min(std::max(normalized, -1.0f), 1.0f);
-
-                            if (normalized < 0.0f) {
-                                // Concave (blue to white)
-                                colorBuffer[i * 3 + 0] = 1.0f + normalized;  // fades R from 1→0
-                                colorBuffer[i * 3 + 1] = 1.0f + normalized;  // fades G from 1→0
-                                colorBuffer[i * 3 + 2] = 1.0f;               // full blue
-                            } else {
-                                // Convex (white to red)
-                                colorBuffer[i * 3 + 0] = 1.0f;               // full red
-                                colorBuffer[i * 3 + 1] = 1.0f - normalized;  // fades G from 1→0
-                                colorBuffer[i * 3 + 2] = 1.0f - normalized;  // fades B from 1→0
-                            }
-                            break;
-                        }
-                    default:
-                        colorBuffer[i * 3 + 0] = m_meshColor.x();
-                        colorBuffer[i * 3 + 1] = m_meshColor.y();
-                        colorBuffer[i * 3 + 2] = m_meshColor.z();
-                        break;
-                }
-                he = he->next;
+                colorBuffer[i * 4 + 0] = color.x();
+                colorBuffer[i * 4 + 1] = color.y();
+                colorBuffer[i * 4 + 2] = color.z();
+                colorBuffer[i * 4 + 3] = selected ? 1.0f : 0.0f;
             }
         }
 
         glBindBuffer(GL_ARRAY_BUFFER, m_VBOmesh);
-        void* ptr = glMapBufferRange(GL_ARRAY_BUFFER, offset, length, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        void* ptr = glMapBufferRange(GL_ARRAY_BUFFER, offset, length, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
         if(ptr) {
             memcpy(ptr, colorBuffer.data(), length);
         }
@@ -66,7 +66,44 @@ void MeshData::refreshTriangleColor(MeshVisMode mode, float scalar) {
     }
 }
 
+void MeshData::refreshScalarField() {
+    m_colorDirty &= ~(ColorDirtyPositions | ColorDirtyCurvature);
+    if (isHeadless()) return;
+
+    PROFILE_SCOPE("Upload curvature");
+    PROFILE_GPU_SCOPE("Upload curvature");
+
+    // Signed mean curvature per corner, the shader maps it through the colormap
+    {
+        size_t vertCounts = m_triangles.size() * 3;
+        size_t offset = vertCounts * 10 * sizeof(float); // Skip data of Pos + Norm + Color
+        size_t length = vertCounts * sizeof(float);
+
+        std::vector<float> scalarBuffer(vertCounts);
+        for (size_t tri_i = 0; tri_i < m_triangles.size(); ++tri_i) {
+            HalfEdge* he = m_triangles[tri_i].he->prev;
+            for (int j = 0; j < 3; ++j) {
+                const Vertex& v = *he->vertex;
+                double sign = v.meanCurvatureNormal.dot(v.normal) >= 0 ? 1.0 : -1.0;
+                scalarBuffer[tri_i * 3 + j] = static_cast<float>(sign * v.meanCurvatureNormal.norm());
+                he = he->next;
+            }
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, m_VBOmesh);
+        void* ptr = glMapBufferRange(GL_ARRAY_BUFFER, offset, length, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+        if(ptr) {
+            memcpy(ptr, scalarBuffer.data(), length);
+        }
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+}
+
 void MeshData::refreshEdgeColor() {
+    if (isHeadless()) return;
+
     // Edges data
     // Data of Edges: [ X Y Z ] [ R G B ]
     {
@@ -83,7 +120,7 @@ void MeshData::refreshEdgeColor() {
         }
 
         glBindBuffer(GL_ARRAY_BUFFER, m_VBOwireframe);
-        void* ptr = glMapBufferRange(GL_ARRAY_BUFFER, offset, length, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        void* ptr = glMapBufferRange(GL_ARRAY_BUFFER, offset, length, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
         if(ptr) {
             memcpy(ptr, colorBuffer.data(), length);
         }
@@ -93,30 +130,15 @@ void MeshData::refreshEdgeColor() {
     }
 }
 
-void MeshData::changeTriangleColor(int idx, Eigen::Vector3f color) {
-    size_t vertCounts = m_selectedTriangles.size() * 3;
-    size_t offsetColor = vertCounts * 3 * 2 * sizeof(float); // Skip Pos + Normal
-
-    size_t offset = offsetColor + idx * 3 * 3 * sizeof(float);
-    size_t length = 3 * 3 * sizeof(float);
-
-    std::vector<float> blueColor = {
-        0.0f, 0.0f, 1.0f,
-        0.0f, 0.0f, 1.0f,
-        0.0f, 0.0f, 1.0f
-    };
-
-    glBindBuffer(GL_ARRAY_BUFFER, m_VBOmesh);
-    void* ptr = glMapBufferRange(GL_ARRAY_BUFFER, offset, length, GL_MAP_WRITE_BIT);
-    if (ptr) {
-        memcpy(ptr, blueColor.data(), length);
-    }
-    glUnmapBuffer(GL_ARRAY_BUFFER);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-}
-
 void MeshData::changeVertexPosition(int idx, Eigen::Vector3f pos) {
     m_vertices[idx].pos = pos.cast<double>();
+    m_colorDirty |= ColorDirtyPositions;
+    m_dirtyGeometryVertices.push_back(idx);
+    m_movedVertices.push_back(idx);
+    if (isHeadless()) return;
+
+    PROFILE_SCOPE("Upload dragged vertex");
+    PROFILE_GPU_SCOPE("Upload dragged vertex");
     {
         size_t vertCounts = m_triangles.size() * 3;
         size_t length = vertCounts * 3 * sizeof(float);
@@ -180,8 +202,21 @@ void MeshData::changeVertexPosition(int idx, Eigen::Vector3f pos) {
     m_pointCloud->updateOffset(idx, pos);
 }
 
- void MeshData::refreshPosition() {
+void MeshData::refreshPosition() {
+    PROFILE_SCOPE("Upload pose");
+    PROFILE_GPU_SCOPE("Upload pose");
+    typedef std::chrono::steady_clock Clock;
+    m_colorDirty |= ColorDirtyPositions;
+    m_geometryDirty = true;
+
+    // Normals are still kept current, only the uploads are skipped
+    if (isHeadless()) {
+        computeVertexNormals();
+        return;
+    }
+
     {
+        auto start = Clock::now();
         size_t vertCounts = m_triangles.size() * 3;
         size_t length = vertCounts * 3 * sizeof(float);
 
@@ -206,6 +241,44 @@ void MeshData::changeVertexPosition(int idx, Eigen::Vector3f pos) {
         memcpy((char*)ptr, replacement.data(), length);
         glUnmapBuffer(GL_ARRAY_BUFFER);
         glBindBuffer(GL_ARRAY_BUFFER, 0);
+        m_poseTimings.positionUploadMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    {
+        auto start = Clock::now();
+        {
+            PROFILE_SCOPE("Vertex normals");
+            computeVertexNormals();
+        }
+        auto computed = Clock::now();
+
+        size_t vertCounts = m_triangles.size() * 3;
+        size_t offset = vertCounts * 3 * sizeof(float); // Skip data of Pos
+        size_t length = vertCounts * 3 * sizeof(float);
+
+        std::vector<float> normalBuffer(vertCounts * 3);
+        Parallel::forEach(0, static_cast<int>(m_triangles.size()), [&](int t_idx) {
+            HalfEdge* he = m_triangles[t_idx].he->prev;
+            for(int it = 0; it < 3; it++) {
+                const Eigen::Vector3d& n = he->vertex->normal;
+                float* dst = &normalBuffer[(t_idx * 3 + it) * 3];
+                dst[0] = static_cast<float>(n[0]);
+                dst[1] = static_cast<float>(n[1]);
+                dst[2] = static_cast<float>(n[2]);
+                he = he->next;
+            }
+        }, 4096);
+
+        glBindBuffer(GL_ARRAY_BUFFER, m_VBOmesh);
+        void* ptr = glMapBufferRange(GL_ARRAY_BUFFER, offset, length, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+        if(ptr) {
+            memcpy(ptr, normalBuffer.data(), length);
+        }
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        m_poseTimings.normalComputeMs = std::chrono::duration<double, std::milli>(computed - start).count();
+        m_poseTimings.normalUploadMs = std::chrono::duration<double, std::milli>(Clock::now() - computed).count();
     }
 
     {
@@ -234,12 +307,219 @@ void MeshData::changeVertexPosition(int idx, Eigen::Vector3f pos) {
     }
 }
 
+void MeshData::refreshPosition(const std::vector<int>& vertices) {
+    // A large region touches most of the buffer anyway, the full path streams it in one go
+    if (vertices.size() * 4 > m_vertices.size() || m_faceNormals.size() != m_triangles.size()) {
+        refreshPosition();
+        return;
+    }
+
+    PROFILE_SCOPE("Upload region pose");
+    PROFILE_GPU_SCOPE("Upload region pose");
+    m_colorDirty |= ColorDirtyPositions;
+    m_dirtyGeometryVertices.insert(m_dirtyGeometryVertices.end(), vertices.begin(), vertices.end());
+
+    // Moved vertices change the normals of their faces, those reach every corner of the faces,
+    // and those corner normals show up in all of their own faces
+    std::vector<char> vertexMark(m_vertices.size(), 0), faceMark(m_triangles.size(), 0);
+    std::vector<int> movedFaces, normalVertices;
+    for (int idx : vertices) {
+        forEachIncoming(m_vertices[idx], [&](HalfEdge* he) {
+            const int f = he->face->index;
+            if (faceMark[f]) return;
+            faceMark[f] = 1;
+            movedFaces.push_back(f);
+        });
+    }
+    for (int f : movedFaces) {
+        const HalfEdge* he = m_triangles[f].he;
+        const Eigen::Vector3d& p0 = he->prev->vertex->pos;
+        m_faceNormals[f] = (he->vertex->pos - p0).cross(he->next->vertex->pos - p0);
+        for (int j = 0; j < 3; ++j) {
+            if (!vertexMark[he->vertex->index]) {
+                vertexMark[he->vertex->index] = 1;
+                normalVertices.push_back(he->vertex->index);
+            }
+            he = he->next;
+        }
+    }
+
+    std::vector<int> faces(movedFaces);
+    for (int vi : normalVertices) {
+        Vertex& v = m_vertices[vi];
+        Eigen::Vector3d normal = Eigen::Vector3d::Zero();
+        forEachIncoming(v, [&](HalfEdge* he) {
+            const int f = he->face->index;
+            normal += m_faceNormals[f];
+            if (!faceMark[f]) {
+                faceMark[f] = 1;
+                faces.push_back(f);
+            }
+        });
+        double length = normal.norm();
+        if (length > 1e-12) v.normal = normal / length;
+    }
+
+    if (isHeadless()) return;
+
+    // Positions and normals of every corner of the touched faces, mapped over the face range they span
+    {
+        int minFace = static_cast<int>(m_triangles.size()), maxFace = -1;
+        for (int f : faces) {
+            minFace = std::min(minFace, f);
+            maxFace = std::max(maxFace, f);
+        }
+        if (maxFace < 0) return;
+
+        size_t vertCounts = m_triangles.size() * 3;
+        size_t offset = minFace * 3 * 3 * sizeof(float);
+        size_t length = (maxFace - minFace + 1) * 3 * 3 * sizeof(float);
+
+        glBindBuffer(GL_ARRAY_BUFFER, m_VBOmesh);
+        for (int section = 0; section < 2; ++section) {
+            // Section 0 is Pos, 1 is Norm
+            float* ptr = static_cast<float*>(glMapBufferRange(GL_ARRAY_BUFFER, section * vertCounts * 3 * sizeof(float) + offset,
+                                                              length, GL_MAP_WRITE_BIT));
+            if (!ptr) break;
+            for (int f : faces) {
+                HalfEdge* he = m_triangles[f].he->prev;
+                for (int it = 0; it < 3; it++) {
+                    const Eigen::Vector3d& value = section == 0 ? he->vertex->pos : he->vertex->normal;
+                    float* dst = ptr + ((f - minFace) * 3 + it) * 3;
+                    dst[0] = static_cast<float>(value[0]);
+                    dst[1] = static_cast<float>(value[1]);
+                    dst[2] = static_cast<float>(value[2]);
+                    he = he->next;
+                }
+            }
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    // Edges with a moved end, same layout as the full upload: he->vertex first, then the other end
+    {
+        std::vector<char> edgeMark(m_edges.size(), 0);
+        std::vector<int> edges;
+        int minEdge = static_cast<int>(m_edges.size()), maxEdge = -1;
+        auto addEdge = [&](const Edge* e) {
+            if (edgeMark[e->index]) return;
+            edgeMark[e->index] = 1;
+            edges.push_back(e->index);
+            minEdge = std::min(minEdge, static_cast<int>(e->index));
+            maxEdge = std::max(maxEdge, static_cast<int>(e->index));
+        };
+        for (int idx : vertices) {
+            forEachIncoming(m_vertices[idx], [&](HalfEdge* he) {
+                addEdge(he->edge);
+                if (!he->twin) addEdge(he->next->edge); // Open ring, the outgoing boundary edge
+            });
+        }
+        if (maxEdge < 0) return;
+
+        size_t offset = minEdge * 2 * 3 * sizeof(float);
+        size_t length = (maxEdge - minEdge + 1) * 2 * 3 * sizeof(float);
+
+        glBindBuffer(GL_ARRAY_BUFFER, m_VBOwireframe);
+        float* ptr = static_cast<float*>(glMapBufferRange(GL_ARRAY_BUFFER, offset, length, GL_MAP_WRITE_BIT));
+        if (ptr) {
+            for (int ei : edges) {
+                const HalfEdge* he = m_edges[ei].he;
+                const Eigen::Vector3d& p0 = he->vertex->pos;
+                const Eigen::Vector3d& p1 = he->prev->vertex->pos; // Start of he, the end of its twin
+                float* dst = ptr + (ei - minEdge) * 2 * 3;
+                for (int k = 0; k < 3; ++k) {
+                    dst[k] = static_cast<float>(p0[k]);
+                    dst[3 + k] = static_cast<float>(p1[k]);
+                }
+            }
+        }
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+}
+
+void MeshData::uploadSkinWeights(const std::shared_ptr<HandleWeights>& weights) {
+    if (isHeadless()) {
+        m_skinWeights = weights;
+        return;
+    }
+
+    // Expanding to corners is a pass over every triangle, a worker does it and the main thread only uploads.
+    // m_F lists the corners in the order of the mesh VBO, the worker works on copies and never sees the half-edges.
+    struct SkinBuffers {
+        Eigen::MatrixXd rest;
+        Eigen::MatrixXi faces;
+        std::vector<float> bindPositions, weights;
+        std::vector<int> indices;
+    };
+    std::shared_ptr<SkinBuffers> buffers = std::make_shared<SkinBuffers>();
+    buffers->rest = m_V;
+    buffers->faces = m_F;
+    m_uploadingWeights = weights;
+
+    TaskScheduler::instance().asyncThenMain("Expand skinning weights", [buffers, weights]() {
+        // Bind pose is the rest pose the weights were computed on
+        const int K = HandleWeights::kInfluences;
+        const size_t vertCounts = buffers->faces.rows() * 3;
+        buffers->bindPositions.resize(vertCounts * 3);
+        buffers->indices.resize(vertCounts * K);
+        buffers->weights.resize(vertCounts * K);
+        Parallel::forEach(0, static_cast<int>(buffers->faces.rows()), [&](int t_idx) {
+            for (int it = 0; it < 3; it++) {
+                const int v = buffers->faces(t_idx, it);
+                const size_t corner = t_idx * 3 + it;
+                for (int k = 0; k < 3; ++k) {
+                    buffers->bindPositions[corner * 3 + k] = static_cast<float>(buffers->rest(v, k));
+                }
+                for (int k = 0; k < K; ++k) {
+                    buffers->indices[corner * K + k] = weights->indices(v, k);
+                    buffers->weights[corner * K + k] = weights->weights(v, k);
+                }
+            }
+        }, 4096);
+        return buffers;
+    }, [this, weights](const std::shared_ptr<SkinBuffers>& expanded) {
+        if (weights != m_uploadingWeights) return; // A newer set is on its way, it replaces this one
+        m_uploadingWeights.reset();
+
+        PROFILE_SCOPE("Upload skinning weights");
+        PROFILE_GPU_SCOPE("Upload skinning weights");
+        m_mesh->setSkinWeights(expanded->bindPositions, expanded->indices, expanded->weights);
+        m_skinWeights = weights;
+        previewSkinnedPose();
+    });
+}
+
+bool MeshData::uploadHandleOffsets(bool keyframed, float time) {
+    if (!skinningReady()) return false;
+
+    PROFILE_SCOPE("Upload handle offsets");
+    const Eigen::VectorXi& handles = m_skinWeights->handles;
+    std::vector<float> offsets(handles.size() * 4, 0.0f);
+    for (int i = 0; i < handles.size(); ++i) {
+        Vertex& v = m_vertices[handles(i)];
+        const Eigen::Vector3d pos = keyframed ? v.getInterpolatedPos(time) : v.pos;
+        for (int k = 0; k < 3; ++k) {
+            offsets[i * 4 + k] = static_cast<float>(pos[k] - m_V(handles(i), k));
+        }
+
+        // Only the handles are drawn as points, the rest of the cloud can stay behind
+        Eigen::Vector3f pointPos = pos.cast<float>();
+        m_pointCloud->updateOffset(handles(i), pointPos);
+    }
+
+    m_mesh->setHandleOffsets(offsets);
+    m_mesh->setSkinning(true);
+    return true;
+}
 
 void MeshData::refreshPosition(float time) {
+    PROFILE_SCOPE("Interpolate pose");
     for (Vertex& v: m_vertices) {
         Eigen::Vector3d interpolated = v.getInterpolatedPos(time);
         Eigen::Vector3f interpolated_float = interpolated.cast<float>();
-        m_pointCloud->updateOffset(v.index, interpolated_float);
+        if (m_pointCloud) m_pointCloud->updateOffset(v.index, interpolated_float);
         v.pos = interpolated;
     }
     refreshPosition();
@@ -1,63 +1,25 @@
 #include "MeshData.hpp"
 
-#include <assimp/Importer.hpp>
-#include <assimp/scene.h>
-#include <assimp/postprocess.h>
+#include "MeshLoader.hpp"
+#include "../Utilities/Parallel.hpp"
+
 #include <map>
 
 MeshData::MeshData(Shader* shader, Shader* wireframe_shader, Shader* pointcloud_shader, const std::string& filePath)
-: m_meshColor(0.8f, 0.2f, 0.2f), m_wireframeColor(1.0f, 1.0f, 1.0f), m_pointsColor(0.1f, 0.1f, 0.9f), lastSelectedVertex(-1) {
-    Assimp::Importer importer;
-	const aiScene* scene = importer.ReadFile( filePath,
-    	aiProcess_Triangulate |
-        aiProcess_JoinIdenticalVertices |
-        aiProcess_CalcTangentSpace |
-        aiProcess_SortByPType |
-        aiProcess_ValidateDataStructure |
-        aiProcess_ImproveCacheLocality);
-
-	if(!scene) {
-	    std::cout << "Couldn't load model " << filePath << '\n';
-		std::terminate();
-	}
-
-	std::cout << "Loading 3D model " << filePath << '\n';
-
-	for(int i = 0; i < /*scene->mNumMeshes*/ 1; i++) {
-	    std::vector<Eigen::Vector3f> vertices;
-        std::vector<Eigen::Vector3f> normals;
-        std::vector<Eigen::Vector3i> indices;
-
-		aiMesh* mesh = scene->mMeshes[i];
-
-		if(mesh->mNormals == nullptr) {
-		    std::cout << "NullPtr Normal\n";
-		}
-
-		// Vertices & Normals
-		for(int j = 0; j < mesh->mNumVertices; j++) {
-		    aiVector3D position = mesh->mVertices[j];
-			vertices.push_back(Eigen::Vector3f(position.x, position.y, position.z));
-
-			if(mesh->mNormals != nullptr) {
-			    aiVector3D normal = mesh->mNormals[j];
-				normals.push_back(Eigen::Vector3f(normal.x, normal.y, normal.z));
-			}
-			else{
-			    normals.push_back(Eigen::Vector3f(1.0f, 0.0f, 0.0f));
-			}
-		}
-
-		// Indices
-		for(int j = 0; j < mesh->mNumFaces; j++) {
-			aiFace face = mesh->mFaces[j];
-			indices.push_back(Eigen::Vector3i(face.mIndices[0], face.mIndices[1], face.mIndices[2]));
-		}
-
-		// Push to list of meshes
-		init(vertices, normals, indices);
-		initVisualizer(shader, wireframe_shader, pointcloud_shader, vertices, normals, indices);
-	}
+: m_geometryDirty(true), m_meshColor(0.8f, 0.2f, 0.2f), m_wireframeColor(1.0f, 1.0f, 1.0f), m_pointsColor(0.1f, 0.1f, 0.9f), m_meshSelectColor(0.0f, 0.0f, 1.0f),
+  lastSelectedVertex(-1), m_selectedHandlesDirty(true), m_appliedPoseVersion(0), m_restDiagonal(0.0), m_lastRoiVertexCount(-1), m_pendingBakes(0),
+  m_pendingWeights(0), m_skinPreview(false), m_mesh(nullptr), m_wireframe(nullptr), m_pointCloud(nullptr), m_colorDirty(ColorDirtySelection | ColorDirtyCurvature) {
+    std::vector<Eigen::Vector3f> vertices;
+    std::vector<Eigen::Vector3f> normals;
+    std::vector<Eigen::Vector3i> indices;
+
+    if(!MeshLoader::load(filePath, vertices, normals, indices)) {
+        std::terminate();
+    }
+
+    init(vertices, normals, indices);
+    computeGeometryAttributes();
+    initVisualizer(shader, wireframe_shader, pointcloud_shader, vertices, normals, indices);
 
     m_VBOmesh = m_mesh->getVBO();
     m_VBOwireframe = m_wireframe->getVBO();
@@ -67,6 +29,20 @@ MeshData::MeshData(Shader* shader, Shader* wireframe_shader, Shader* pointcloud_
     saveTimeFrame(0);
 }
 
+MeshData::MeshData(const std::vector<Eigen::Vector3f>& vertices, const std::vector<Eigen::Vector3f>& normals,
+                   const std::vector<Eigen::Vector3i>& indices)
+: m_VBOmesh(0), m_VBOwireframe(0),
+  m_geometryDirty(true), m_meshColor(0.8f, 0.2f, 0.2f), m_wireframeColor(1.0f, 1.0f, 1.0f), m_pointsColor(0.1f, 0.1f, 0.9f), m_meshSelectColor(0.0f, 0.0f, 1.0f),
+  lastSelectedVertex(-1), m_selectedHandlesDirty(true), m_appliedPoseVersion(0), m_restDiagonal(0.0), m_lastRoiVertexCount(-1), m_pendingBakes(0),
+  m_pendingWeights(0), m_skinPreview(false), m_mesh(nullptr), m_wireframe(nullptr), m_pointCloud(nullptr), m_colorDirty(ColorDirtySelection | ColorDirtyCurvature) {
+    init(vertices, normals, indices);
+    computeGeometryAttributes();
+    resetSelection();
+
+    precomputeARAP();
+    saveTimeFrame(0);
+}
+
 void MeshData::init(const std::vector<Eigen::Vector3f>& vertices, const std::vector<Eigen::Vector3f>& normals,
                     const std::vector<Eigen::Vector3i>& indices) {
     m_vertices.resize(vertices.size());
@@ -74,14 +50,14 @@ void MeshData::init(const std::vector<Eigen::Vector3f>& vertices, const std::vec
     m_halfEdges.resize(indices.size() * 3);
 
     // Setup Vertices ========================================
-    for(int i = 0; i < vertices.size(); i++) {
+    Parallel::forEach(0, static_cast<int>(vertices.size()), [&](int i) {
         m_vertices[i].pos = vertices[i].cast<double>();
         m_vertices[i].normal = normals[i].cast<double>();
         m_vertices[i].index = i;
 
         m_vertices[i].originalPos = m_vertices[i].pos;
         // m_vertices[i].deformedRot = Eigen::Matrix4d::Identity();
-    }
+    }, 4096, "setup vertices");
 
     // Setup HalfEdge ========================================
     std::map<std::pair<int, int>, HalfEdge*> edgeMap;
@@ -165,6 +141,7 @@ void MeshData::init(const std::vector<Eigen::Vector3f>& vertices, const std::vec
     // Setup Selection =====================================
     m_selectedEdges.resize(m_edges.size(), false);
     m_selectedVertices.resize(m_vertices.size(), false);
+    m_selectedHandlesDirty = true;
     m_selectedTriangles.resize(m_triangles.size(), false);
 }
 
@@ -198,7 +175,66 @@ void MeshData::initVisualizer(Shader* shader, Shader* wireframe_shader, Shader*
 }
 
 void MeshData::draw(const CameraParam& cameraParam) {
+    if (isHeadless()) return;
+
     m_mesh->draw(cameraParam);
-    m_wireframe->draw(cameraParam);
+    if (!m_mesh->isSkinning()) {
+        m_wireframe->draw(cameraParam); // Would still show the pose before the skinning preview
+    }
     m_pointCloud->draw(cameraParam, m_selectedVertices);
 }
+
+void MeshData::collectMemoryUsage(MemoryStats::Report& report) {
+    using MemoryStats::add;
+    using MemoryStats::bytes;
+
+    add(report, "Mesh", "Half-edges", m_halfEdges.size(), bytes(m_halfEdges));
+    add(report, "Mesh", "Vertices", m_vertices.size(), bytes(m_vertices));
+    add(report, "Mesh", "Edges", m_edges.size(), bytes(m_edges));
+    add(report, "Mesh", "Triangles", m_triangles.size(), bytes(m_triangles));
+    add(report, "Mesh", "Corner areas, face normals", m_cornerAreas.size() + m_faceNormals.size(),
+        bytes(m_cornerAreas) + bytes(m_faceNormals) + bytes(m_dirtyGeometryVertices));
+    add(report, "Mesh", "Selection flags", m_selectedVertices.size() + m_selectedEdges.size() + m_selectedTriangles.size(),
+        bytes(m_selectedVertices) + bytes(m_selectedEdges) + bytes(m_selectedTriangles));
+    add(report, "Mesh", "ARAP input (V, F)", m_V.rows(), bytes(m_V) + bytes(m_F));
+
+    // The map headers are part of sizeof(Vertex) above, this is only the nodes
+    size_t keyframes = 0, keyframeBytes = 0;
+    for (const Vertex& v : m_vertices) {
+        keyframes += v.timeframePos.size();
+        keyframeBytes += bytes(v.timeframePos);
+    }
+    add(report, "Keyframes", "Vertex::timeframePos", keyframes, keyframeBytes);
+
+    size_t deltas = 0, deltaBytes = bytes(m_storedAnimationFrames);
+    for (const GenAPI::AnimationFrame& frame : m_storedAnimationFrames) {
+        deltas += frame.size();
+        deltaBytes += bytes(frame);
+    }
+    add(report, "Animation", "Stored frames (deltas)", deltas, deltaBytes);
+    add(report, "Animation", "Base positions", m_basePositions.size(), bytes(m_basePositions));
+    if (m_skinWeights) {
+        add(report, "Skinning", "Handle weights", m_skinWeights->weights.size(),
+            bytes(m_skinWeights->indices) + bytes(m_skinWeights->weights));
+    }
+
+    if (m_solver) {
+        const MemoryStats::Report solver = m_solver->getMemoryUsage();
+        report.insert(report.end(), solver.begin(), solver.end());
+    }
+
+    if (m_mesh) {
+        add(report, "GPU", "Mesh VBO", 1, m_mesh->getVBOBytes());
+        if (m_mesh->getSkinBytes() > 0) {
+            add(report, "GPU", "Skinning VBO", 1, m_mesh->getSkinBytes());
+            add(report, "GPU", "Handle offsets", 1, m_mesh->getHandleBytes());
+        }
+    }
+    if (m_wireframe) {
+        add(report, "GPU", "Wireframe VBO", 1, m_wireframe->getVBOBytes());
+    }
+    if (m_pointCloud) {
+        add(report, "GPU", "Point cloud VBO", 1, m_pointCloud->getVBOBytes());
+        add(report, "GPU", "Point cloud EBO", 1, m_pointCloud->getEBOBytes());
+    }
+}
@@ -5,7 +5,10 @@
 #include <Eigen/Sparse>
 #include <glad/glad.h>
 #include <igl/arap.h>
+#include <atomic>
+#include <functional>
 #include <map>
+#include <memory>
 
 #include "../Utilities/Shader.hpp"
 
@@ -15,6 +18,9 @@
 
 // Include GenAPI for animation support
 #include "../GenAPI/GenAPI.hpp"
+#include "AnimationBaker.hpp"
+#include "DeformationSolver.hpp"
+#include "../Utilities/MemoryStats.hpp"
 
 class Vertex;
 class Edge;
@@ -27,6 +33,33 @@ enum MeshVisMode{
     Weight      = 0x2
 };
 
+// Inputs of the per-corner color and scalar sections, each is only re-uploaded when its input changed.
+// Mode and range are shader uniforms and need no upload at all.
+enum ColorDirtyFlag{
+    ColorDirtySelection     = 0x1,
+    ColorDirtyPositions     = 0x2,
+    ColorDirtyCurvature     = 0x4
+};
+
+// Cost of the last full pose update, normals are measured against the position upload they ride along with
+struct PoseUpdateTimings {
+    double positionUploadMs = 0.0;
+    double normalComputeMs = 0.0;
+    double normalUploadMs = 0.0;
+};
+
+// Region-of-interest ARAP: only the region is solved, the ring of vertices around it stays where it is
+enum class RoiSource {
+    Radius,             // Geodesic radius around the handles moved since the last solve
+    SelectedTriangles   // Vertices of the selected triangles
+};
+
+struct RoiOptions {
+    bool enabled = false;
+    RoiSource source = RoiSource::Radius;
+    double radius = 0.2; // Fraction of the rest pose bounding box diagonal
+};
+
 // MeshData ======================================================================================
 class MeshData{
 private:
@@ -43,6 +76,9 @@ public:
     // Yes, there will be a duplicate vertices inside VBO
 
     MeshData(Shader* shader, Shader* wireframe_shader, Shader* pointcloud_shader, const std::string& filePath);
+    // Headless, no visualizer and every GL upload is skipped. For tools and benchmarks without a context
+    MeshData(const std::vector<Eigen::Vector3f>& vertices, const std::vector<Eigen::Vector3f>& normals,
+             const std::vector<Eigen::Vector3i>& indices);
     void init(const std::vector<Eigen::Vector3f>& vertices, const std::vector<Eigen::Vector3f>& normals,
               const std::vector<Eigen::Vector3i>& indices);
     void initVisualizer(Shader* shader, Shader* wireframe_shader, Shader* pointcloud_shader,
@@ -55,6 +91,21 @@ public:
     const std::vector<Vertex>& getVertices() { return m_vertices; }
 
     Vertex& getVertex(int idx) { return m_vertices[idx]; }
+    bool isHeadless() const { return m_mesh == nullptr; }
+
+    void collectMemoryUsage(MemoryStats::Report& report); // Render thread, the solver reports its own state
+
+    // Geometry Attributes =============================================================================================================
+private:
+    std::vector<double> m_cornerAreas;          // Mixed area each face gives to he->vertex, same indexing as m_halfEdges
+    std::vector<Eigen::Vector3d> m_faceNormals; // Area weighted, scratch for computeVertexNormals
+    std::vector<int> m_dirtyGeometryVertices;   // Moved since the last update
+    bool m_geometryDirty;                       // Everything moved, skip the incremental path
+public:
+    void computeGeometryAttributes();
+    void updateGeometryAttributes(const std::vector<int>& vertices);
+    void ensureGeometryAttributes(); // Catches up with pending position changes
+    void computeVertexNormals();
 
     // Selection =============================================================================================================
 private:
@@ -67,6 +118,9 @@ private:
 
     int lastSelectedVertex;
 
+    std::vector<int> m_selectedHandles; // Selected vertex indices, ascending
+    bool m_selectedHandlesDirty;        // Set by everything that writes m_selectedVertices
+
 public:
     void resetSelection();
     void selectTriangle(const Eigen::Vector3f& cam_org, const Eigen::Vector3f& nearPoint);
@@ -75,7 +129,9 @@ public:
     void selectEdges(); // TODO
 
     const std::vector<bool>& getSelectedVertices(){ return m_selectedVertices; }
+    const std::vector<int>& selectedHandles(); // Rebuilt only after the selection changed
 
+    int pickTriangle(const Eigen::Vector3f& org, const Eigen::Vector3f& dir, float& closest_t); // Closest hit or -1
     static bool rayIntersectTriangle(const Eigen::Vector3f& org, const Eigen::Vector3f& dir, const Triangle& tri,
                                      Eigen::Vector3f& intersectPoint, float& t);
 
@@ -85,47 +141,107 @@ private:
     // Processor Implementation =============================================================================================================
     Eigen::MatrixXd m_V;   // Original positions
     Eigen::MatrixXi m_F;   // Face indices
-    Eigen::VectorXi m_b;   // Constraint indices
-    Eigen::MatrixXd m_bc;  // Constraint positions
-    igl::ARAPData   m_arap_data;
+    uint64_t m_appliedPoseVersion;
+
+    ArapSettings m_arapSettings;
+    RoiOptions m_roiOptions;
+    std::vector<int> m_movedVertices;   // Dragged since the last computeARAP, seeds of the radius region
+    double m_restDiagonal;
+    int m_lastRoiVertexCount;           // Vertices in the last region solve, -1 after a full solve
+    ArapSolveStats m_lastSolveStats;    // Of the last live or region pose applied
+
+    std::vector<int> computeRoi(const std::vector<int>& handles, const std::vector<int>& moved);
+    bool solveRegion(const std::vector<int>& handles, const std::vector<int>& moved);
 public:
     void precomputeARAP();
-    void precomputeConstraint();
-    void computeARAP();
+    const Eigen::MatrixXd& getRestPositions() const { return m_V; }
+    const Eigen::MatrixXi& getFaces() const { return m_F; }
+    void computeARAP(); // Queued on the solver thread, the result shows up in consumeSolverResults
+    void computeLaplacianSurfaceModeling(); // Same hand-off, prefactorized per handle set, for previews while dragging
+    void solveKeyframes(const std::vector<float>& times); // ARAP at every time with the handles' keyframed positions
+    bool consumeSolverResults(float time); // Render thread, applies and uploads finished solves
+    bool isSolving() const { return m_solver && m_solver->isBusy(); }
+    void setArapSettings(const ArapSettings& settings) { m_arapSettings = settings; }
+    void setRoiOptions(const RoiOptions& options) { m_roiOptions = options; }
+    int getLastRoiVertexCount() const { return m_lastRoiVertexCount; }
+    const ArapSolveStats& getLastSolveStats() const { return m_lastSolveStats; }
     void saveTimeFrame(float time);
     
     // Animation frame management
-    void storeAnimationFrames(const GenAPI::AnimationSequence& frames);
+    void storeAnimationFrames(const GenAPI::AnimationSequence& frames); // Bakes in the background
     void applyAnimationFrame(int frameIndex);
     void clearAnimationFrames();
     bool hasAnimationFrames() const;
     int getAnimationFrameCount() const;
 
+    // Background bake hand-off, snapshot and consume are render thread only, publish is any thread
+    BakeInput snapshotForBake();
+    void publishAnimation(const std::shared_ptr<BakedAnimation>& baked);
+    bool consumePublishedAnimation();
+    bool isBaking() const { return m_pendingBakes > 0; }
+    void setBakeDynamics(const BakeDynamics& dynamics) { m_bakeDynamics = dynamics; } // For the next bake
+    void setWorkFinishedCallback(const std::function<void()>& callback) { m_solver->setPublishCallback(callback); } // Invoked on the solver thread
+
 private:
     // Animation Implementation =============================================================================================================
     GenAPI::AnimationSequence m_storedAnimationFrames;
     std::map<int, Eigen::Vector3d> m_basePositions; // Store base positions before animation
+
+    std::shared_ptr<BakedAnimation> m_publishedAnimation; // Only accessed through std::atomic_load/atomic_exchange
+    std::atomic<int> m_pendingBakes;
+    BakeDynamics m_bakeDynamics;
+
+    // Skinning Preview =============================================================================================================
+    // Handles blend the rest pose through precomputed weights in the vertex shader, no solve and no pose upload
+    std::shared_ptr<HandleWeights> m_publishedWeights; // Only accessed through std::atomic_load/atomic_exchange
+    std::shared_ptr<HandleWeights> m_skinWeights;      // Uploaded, render thread only
+    std::shared_ptr<HandleWeights> m_uploadingWeights; // Being expanded to corners on the pool, render thread only
+    std::atomic<int> m_pendingWeights;
+    bool m_skinPreview;
+
+    bool skinningReady(); // Weights match the selection, asks for new ones if not
+    bool uploadHandleOffsets(bool keyframed, float time);
+    void uploadSkinWeights(const std::shared_ptr<HandleWeights>& weights);
+public:
+    void setSkinningPreview(bool enabled);
+    void computeSkinningWeights(); // Queued on the solver thread like a bake
+    void consumeSkinningWeights(); // Render thread, starts the upload of finished weights
+    bool previewSkinnedPose() { return uploadHandleOffsets(false, 0.0f); }         // Handles where they are now
+    bool previewSkinnedPose(float time) { return uploadHandleOffsets(true, time); } // Handles at their keyframes
+    bool isComputingWeights() const { return m_pendingWeights > 0 || m_uploadingWeights; }
+    int getSkinHandleCount() const { return m_skinWeights ? static_cast<int>(m_skinWeights->handles.size()) : 0; }
+
+private:
+    std::unique_ptr<DeformationSolver> m_solver; // Last, so its thread is joined before the state it reports into goes away
     
     // Visualization Implementation =============================================================================================================
     Object::Mesh* m_mesh;
     Object::Wireframe* m_wireframe;
     Object::PointCloud* m_pointCloud;
+
+    unsigned int m_colorDirty;  // ColorDirtyFlag bits
+    PoseUpdateTimings m_poseTimings;
 public:
-    void refreshTriangleColor(MeshVisMode mode, float scalar = 0.08f);
+    void updateTriangleColor(MeshVisMode mode, float scalar = 0.08f); // Uploads only if an input changed
+    void refreshTriangleColor();
+    void refreshScalarField();
     void refreshEdgeColor();
+    void markColorDirty(unsigned int flags) { m_colorDirty |= flags; }
 
-    void changeTriangleColor(int idx, Eigen::Vector3f color);
     void changeVertexPosition(int idx, Eigen::Vector3f pos);
 
-    void refreshPosition();
+    void refreshPosition(); // Also recomputes and uploads the normals
     void refreshPosition(float time);
+    void refreshPosition(const std::vector<int>& vertices); // Only the faces and edges around these vertices
+    const PoseUpdateTimings& getPoseUpdateTimings() const { return m_poseTimings; }
 };
 
 // Vertex Data ======================================================================================
 class Vertex {
 public:
     unsigned int index;
-    Eigen::Vector3d meanCurvatureNormal;
+    double area;                            // Mixed Voronoi area
+    Eigen::Vector3d meanCurvatureNormal;    // H * n
 
     HalfEdge* he;
 
@@ -139,7 +255,7 @@ public:
     // Eigen::Matrix4d deformedRot;
 public:
     Vertex() :
-        he(nullptr) {}
+        area(0.0), meanCurvatureNormal(Eigen::Vector3d::Zero()), he(nullptr) {}
     ~Vertex() {}
 
     Eigen::Vector3d getInterpolatedPos(float time);
@@ -149,13 +265,13 @@ public:
 class Edge {
 public:
     unsigned int index;
-    double weight;
+    double weight;      // Cotangent weight, (cot a + cot b) / 2
 
     HalfEdge* he;
 
 public:
     Edge() :
-        he(nullptr) {}
+        weight(0.0), he(nullptr) {}
     ~Edge() {}
 
 };
@@ -176,7 +292,7 @@ public:
 // Half Edge Data ======================================================================================
 class HalfEdge {
 public:
-    double angle;
+    double angle;       // Corner angle opposite this half-edge
 
     HalfEdge* next;
     HalfEdge* prev;
@@ -188,9 +304,31 @@ public:
 
 public:
     HalfEdge() :
-        next(nullptr), prev(nullptr), twin(nullptr),
+        angle(0.0), next(nullptr), prev(nullptr), twin(nullptr),
         vertex(nullptr), edge(nullptr), face(nullptr) {}
     ~HalfEdge() {}
 };
 
+// Calls fn(he) for every half-edge ending at v, also on boundary vertices where the ring is open
+template <typename Func>
+void forEachIncoming(const Vertex& v, Func fn) {
+    HalfEdge* start = v.he;
+    if (!start) return;
+
+    HalfEdge* he = start;
+    do {
+        fn(he);
+        he = he->next->twin;
+    } while (he && he != start);
+
+    if (he) return; // Closed ring
+
+    // Open ring, walk the other way from the start
+    he = start->twin ? start->twin->prev : nullptr;
+    while (he) {
+        fn(he);
+        he = he->twin ? he->twin->prev : nullptr;
+    }
+}
+
 #endif // MESH_DATA_HPP
@@ -0,0 +1,188 @@
+#include "MeshData.hpp"
+#include "../Utilities/Parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// Attributes are computed in three passes, each one walks a contiguous array and only writes its own element:
+//   faces    -> HalfEdge::angle and the mixed area every corner contributes
+//   edges    -> Edge::weight from the angles of the two adjacent faces
+//   vertices -> Vertex::area and Vertex::meanCurvatureNormal from the one-ring
+// so every pass can be split across threads without locking.
+// Vertex normals follow the same pattern: faces accumulate, vertices gather from their ring and normalize.
+
+namespace {
+    const int kMinChunk = 2048;
+
+    double cotangent(double angle) {
+        return std::cos(angle) / std::max(std::sin(angle), 1e-12);
+    }
+
+    // HalfEdge::angle is the corner angle opposite the half-edge, at he->next->vertex
+    void computeFace(const Triangle& tri, double* cornerAreas, const HalfEdge* base) {
+        HalfEdge* corners[3] = { tri.he, tri.he->next, tri.he->prev };
+
+        bool obtuse = false;
+        for (HalfEdge* he : corners) {
+            const Eigen::Vector3d& o = he->next->vertex->pos;
+            Eigen::Vector3d u = he->prev->vertex->pos - o;
+            Eigen::Vector3d w = he->vertex->pos - o;
+            he->angle = std::atan2(u.cross(w).norm(), u.dot(w));
+            obtuse |= he->angle > M_PI_2;
+        }
+
+        const Eigen::Vector3d& p0 = tri.he->prev->vertex->pos;
+        const double area = 0.5 * (tri.he->vertex->pos - p0).cross(tri.he->next->vertex->pos - p0).norm();
+
+        // Mixed Voronoi area (Meyer et al.), stored for the vertex the half-edge ends at.
+        // The corner angle at he->vertex is the one opposite he->prev.
+        for (HalfEdge* he : corners) {
+            double cornerArea;
+            if (obtuse) {
+                cornerArea = he->prev->angle > M_PI_2 ? area * 0.5 : area * 0.25;
+            }
+            else {
+                double lengthIn = (he->vertex->pos - he->prev->vertex->pos).squaredNorm();
+                double lengthOut = (he->next->vertex->pos - he->vertex->pos).squaredNorm();
+                cornerArea = (lengthIn * cotangent(he->angle) + lengthOut * cotangent(he->next->angle)) / 8.0;
+            }
+            cornerAreas[he - base] = cornerArea;
+        }
+    }
+
+    void computeEdge(Edge& edge) {
+        double weight = cotangent(edge.he->angle);
+        if (edge.he->twin) weight += cotangent(edge.he->twin->angle);
+        edge.weight = 0.5 * weight;
+    }
+
+    // Hn = 1 / (2A) * sum_j w_ij (x_i - x_j)
+    void computeVertex(Vertex& v, const double* cornerAreas, const HalfEdge* base) {
+        double area = 0.0;
+        Eigen::Vector3d laplacian = Eigen::Vector3d::Zero();
+
+        forEachIncoming(v, [&](HalfEdge* he) {
+            area += cornerAreas[he - base];
+            laplacian += he->edge->weight * (v.pos - he->prev->vertex->pos);
+
+            // Boundary edge leaving v, no incoming half-edge covers it
+            if (!he->next->twin) {
+                laplacian += he->next->edge->weight * (v.pos - he->next->vertex->pos);
+            }
+        });
+
+        v.area = area;
+        v.meanCurvatureNormal = area > 1e-12 ? Eigen::Vector3d(laplacian / (2.0 * area)) : Eigen::Vector3d::Zero();
+    }
+}
+
+void MeshData::computeVertexNormals() {
+    m_faceNormals.resize(m_triangles.size());
+
+    // Unnormalized cross product, so larger faces weigh more
+    Parallel::forEach(0, static_cast<int>(m_triangles.size()), [&](int i) {
+        const HalfEdge* he = m_triangles[i].he;
+        const Eigen::Vector3d& p0 = he->prev->vertex->pos;
+        m_faceNormals[i] = (he->vertex->pos - p0).cross(he->next->vertex->pos - p0);
+    }, kMinChunk, "face normals");
+
+    Parallel::forEach(0, static_cast<int>(m_vertices.size()), [&](int i) {
+        Vertex& v = m_vertices[i];
+        Eigen::Vector3d normal = Eigen::Vector3d::Zero();
+        forEachIncoming(v, [&](HalfEdge* he) {
+            normal += m_faceNormals[he->face->index];
+        });
+
+        // Fully collapsed ring, keep the last valid normal
+        double length = normal.norm();
+        if (length > 1e-12) v.normal = normal / length;
+    }, kMinChunk, "vertex normals");
+}
+
+void MeshData::computeGeometryAttributes() {
+    m_geometryDirty = false;
+    m_dirtyGeometryVertices.clear();
+    m_cornerAreas.resize(m_halfEdges.size());
+
+    double* cornerAreas = m_cornerAreas.data();
+    const HalfEdge* base = m_halfEdges.data();
+
+    Parallel::forEach(0, static_cast<int>(m_triangles.size()), [&](int i) {
+        computeFace(m_triangles[i], cornerAreas, base);
+    }, kMinChunk, "face angles");
+
+    Parallel::forEach(0, static_cast<int>(m_edges.size()), [&](int i) {
+        computeEdge(m_edges[i]);
+    }, kMinChunk, "edge weights");
+
+    Parallel::forEach(0, static_cast<int>(m_vertices.size()), [&](int i) {
+        computeVertex(m_vertices[i], cornerAreas, base);
+    }, kMinChunk, "vertex curvature");
+
+    m_colorDirty |= ColorDirtyCurvature;
+}
+
+void MeshData::updateGeometryAttributes(const std::vector<int>& vertices) {
+    // Past this point gathering the neighbourhood costs more than it saves
+    if (m_cornerAreas.size() != m_halfEdges.size() || vertices.size() * 4 > m_vertices.size()) {
+        computeGeometryAttributes();
+        return;
+    }
+
+    // A moved vertex changes the angles of its faces, which reach the edges of those faces
+    // and the areas and curvature of every vertex in the one-ring
+    std::vector<char> faceMark(m_triangles.size(), 0), edgeMark(m_edges.size(), 0), vertexMark(m_vertices.size(), 0);
+    std::vector<int> faces, edges, ring;
+
+    for (int idx : vertices) {
+        forEachIncoming(m_vertices[idx], [&](HalfEdge* he) {
+            const int f = he->face->index;
+            if (faceMark[f]) return;
+            faceMark[f] = 1;
+            faces.push_back(f);
+
+            HalfEdge* th = he;
+            for (int j = 0; j < 3; ++j) {
+                if (!edgeMark[th->edge->index]) {
+                    edgeMark[th->edge->index] = 1;
+                    edges.push_back(th->edge->index);
+                }
+                if (!vertexMark[th->vertex->index]) {
+                    vertexMark[th->vertex->index] = 1;
+                    ring.push_back(th->vertex->index);
+                }
+                th = th->next;
+            }
+        });
+    }
+
+    double* cornerAreas = m_cornerAreas.data();
+    const HalfEdge* base = m_halfEdges.data();
+
+    Parallel::forEach(0, static_cast<int>(faces.size()), [&](int i) {
+        computeFace(m_triangles[faces[i]], cornerAreas, base);
+    }, kMinChunk);
+
+    Parallel::forEach(0, static_cast<int>(edges.size()), [&](int i) {
+        computeEdge(m_edges[edges[i]]);
+    }, kMinChunk);
+
+    Parallel::forEach(0, static_cast<int>(ring.size()), [&](int i) {
+        computeVertex(m_vertices[ring[i]], cornerAreas, base);
+    }, kMinChunk);
+
+    m_colorDirty |= ColorDirtyCurvature;
+}
+
+void MeshData::ensureGeometryAttributes() {
+    if (m_geometryDirty) {
+        computeGeometryAttributes();
+    }
+    else if (!m_dirtyGeometryVertices.empty()) {
+        std::vector<int> vertices;
+        vertices.swap(m_dirtyGeometryVertices);
+        std::sort(vertices.begin(), vertices.end());
+        vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+        updateGeometryAttributes(vertices);
+    }
+}
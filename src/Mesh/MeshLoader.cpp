@@ -0,0 +1,104 @@
+#include "MeshLoader.hpp"
+#include "../Utilities/Parallel.hpp"
+#include "../Utilities/Profiler.hpp"
+#include "../Utilities/Logger.hpp"
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <fstream>
+
+bool MeshLoader::load(const std::string& filePath,
+                      std::vector<Eigen::Vector3f>& vertices,
+                      std::vector<Eigen::Vector3f>& normals,
+                      std::vector<Eigen::Vector3i>& indices) {
+    PROFILE_SCOPE("Load mesh");
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile( filePath,
+        aiProcess_Triangulate |
+        aiProcess_JoinIdenticalVertices |
+        aiProcess_CalcTangentSpace |
+        aiProcess_SortByPType |
+        aiProcess_ValidateDataStructure |
+        aiProcess_ImproveCacheLocality);
+
+    if(!scene || scene->mNumMeshes == 0) {
+        LOG_ERROR("Couldn't load model " << filePath);
+        return false;
+    }
+
+    LOG_INFO("Loading 3D model " << filePath);
+
+    vertices.clear();
+    normals.clear();
+    indices.clear();
+
+    // Only the first mesh is used
+    aiMesh* mesh = scene->mMeshes[0];
+
+    if(mesh->mNormals == nullptr) {
+        LOG_WARN("NullPtr Normal");
+    }
+
+    // Vertices & Normals
+    vertices.resize(mesh->mNumVertices);
+    normals.resize(mesh->mNumVertices);
+    Parallel::forEach(0, static_cast<int>(mesh->mNumVertices), [&](int j) {
+        aiVector3D position = mesh->mVertices[j];
+        vertices[j] = Eigen::Vector3f(position.x, position.y, position.z);
+
+        if(mesh->mNormals != nullptr) {
+            aiVector3D normal = mesh->mNormals[j];
+            normals[j] = Eigen::Vector3f(normal.x, normal.y, normal.z);
+        }
+        else{
+            normals[j] = Eigen::Vector3f(1.0f, 0.0f, 0.0f);
+        }
+    }, 8192, "load vertices");
+
+    // Indices
+    indices.resize(mesh->mNumFaces);
+    Parallel::forEach(0, static_cast<int>(mesh->mNumFaces), [&](int j) {
+        const aiFace& face = mesh->mFaces[j];
+        indices[j] = Eigen::Vector3i(face.mIndices[0], face.mIndices[1], face.mIndices[2]);
+    }, 8192, "load faces");
+
+    return true;
+}
+
+void MeshLoader::toMatrices(const std::vector<Eigen::Vector3f>& vertices, const std::vector<Eigen::Vector3i>& indices,
+                            Eigen::MatrixXd& V, Eigen::MatrixXi& F) {
+    V.resize(vertices.size(), 3);
+    for (size_t i = 0; i < vertices.size(); ++i)
+        V.row(i) = vertices[i].cast<double>().transpose();
+
+    F.resize(indices.size(), 3);
+    for (size_t i = 0; i < indices.size(); ++i)
+        F.row(i) = indices[i].transpose();
+}
+
+bool MeshLoader::writePLY(const std::string& filePath, const Eigen::MatrixXd& V, const Eigen::MatrixXi& F) {
+    std::ofstream file(filePath);
+    if (!file.is_open()) {
+        LOG_ERROR("Failed to write " << filePath);
+        return false;
+    }
+
+    file << "ply\n"
+         << "format ascii 1.0\n"
+         << "element vertex " << V.rows() << "\n"
+         << "property float x\n"
+         << "property float y\n"
+         << "property float z\n"
+         << "element face " << F.rows() << "\n"
+         << "property list uchar int vertex_indices\n"
+         << "end_header\n";
+
+    for (int i = 0; i < V.rows(); ++i)
+        file << static_cast<float>(V(i, 0)) << " " << static_cast<float>(V(i, 1)) << " " << static_cast<float>(V(i, 2)) << "\n";
+
+    for (int i = 0; i < F.rows(); ++i)
+        file << "3 " << F(i, 0) << " " << F(i, 1) << " " << F(i, 2) << "\n";
+
+    return file.good();
+}
@@ -0,0 +1,23 @@
+#ifndef MESH_LOADER_HPP
+#define MESH_LOADER_HPP
+
+#include <Eigen/Dense>
+#include <string>
+#include <vector>
+
+// Loads the first mesh of a model file, no GL involved so headless tools can use it too
+namespace MeshLoader {
+    bool load(const std::string& filePath,
+              std::vector<Eigen::Vector3f>& vertices,
+              std::vector<Eigen::Vector3f>& normals,
+              std::vector<Eigen::Vector3i>& indices);
+
+    // Indexed face set in the layout libigl expects
+    void toMatrices(const std::vector<Eigen::Vector3f>& vertices, const std::vector<Eigen::Vector3i>& indices,
+                    Eigen::MatrixXd& V, Eigen::MatrixXi& F);
+
+    // ASCII PLY, positions and faces only
+    bool writePLY(const std::string& filePath, const Eigen::MatrixXd& V, const Eigen::MatrixXi& F);
+}
+
+#endif // MESH_LOADER_HPP
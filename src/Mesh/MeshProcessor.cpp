@@ -1,7 +1,15 @@
 #include "MeshData.hpp"
 #include "../GenAPI/GenAPI.hpp"
+#include "../Utilities/Profiler.hpp"
+#include "../Utilities/Logger.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
 
 void MeshData::precomputeARAP() {
+    PROFILE_SCOPE("precomputeARAP");
     m_V.resize(m_vertices.size(), 3);
     for (int i = 0; i < m_vertices.size(); ++i)
         m_V.row(i) = m_vertices[i].originalPos.transpose();
@@ -16,101 +24,348 @@ void MeshData::precomputeARAP() {
         }
         m_F.row(i) = indices;
     }
+    m_restDiagonal = m_V.rows() > 0 ? (m_V.colwise().maxCoeff() - m_V.colwise().minCoeff()).norm() : 0.0;
+
+    m_solver.reset(new DeformationSolver(m_V, m_F));
 }
 
-void MeshData::precomputeConstraint() {
-    std::vector<int> constraint_indices;
-    for (int i = 0; i < m_selectedVertices.size(); ++i)
-        if (m_selectedVertices[i])
-            constraint_indices.push_back(i);
+void MeshData::saveTimeFrame(float time) {
+    for(Vertex& v: m_vertices) {
+        v.timeframePos[time] = v.pos;
+    }
+}
 
-    m_b.resize(constraint_indices.size());
-    m_bc.resize(constraint_indices.size(), 3);
+void MeshData::computeARAP() {
+    const std::vector<int>& handles = selectedHandles();
+    LOG_DEBUG("computeARAP: " << handles.size() << " handles");
 
-    for (int i = 0; i < constraint_indices.size(); ++i) {
-        int idx = constraint_indices[i];
-        m_b(i) = idx;
-        m_bc.row(i) = m_vertices[idx].pos.transpose();  // Use current handle positions
+    std::vector<int> moved;
+    moved.swap(m_movedVertices);
+    if (m_roiOptions.enabled && solveRegion(handles, moved)) {
+        return;
     }
+    m_lastRoiVertexCount = -1;
 
-    m_arap_data.with_dynamics = false;
-    igl::arap_precomputation(m_V, m_F, m_V.cols(), m_b, m_arap_data);
+    Eigen::MatrixXd targets(handles.size(), 3);
+    for (int i = 0; i < handles.size(); ++i) {
+        targets.row(i) = m_vertices[handles[i]].pos.transpose();  // Use current handle positions
+    }
+    m_solver->solve(Eigen::Map<const Eigen::VectorXi>(handles.data(), handles.size()), targets, m_arapSettings);
 }
 
-void MeshData::saveTimeFrame(float time) {
-    for(Vertex& v: m_vertices) {
-        v.timeframePos[time] = v.pos;
+void MeshData::computeLaplacianSurfaceModeling() {
+    const std::vector<int>& handles = selectedHandles();
+
+    Eigen::MatrixXd targets(handles.size(), 3);
+    for (int i = 0; i < handles.size(); ++i) {
+        targets.row(i) = m_vertices[handles[i]].pos.transpose();
     }
+
+    // Always the whole mesh, the next region solve starts from a clean set of moved handles
+    m_movedVertices.clear();
+    m_lastRoiVertexCount = -1;
+    m_solver->solveLaplacian(Eigen::Map<const Eigen::VectorXi>(handles.data(), handles.size()), targets);
 }
 
-void MeshData::computeARAP() {
-    std::cout << "1111" << std::endl;
-    precomputeConstraint();
-    std::cout << "2222" << std::endl;
-    for (int i = 0; i < m_b.size(); ++i) {
-        int idx = m_b(i);
-        m_bc.row(i) = m_vertices[idx].pos.transpose();  // Update handle target pos
-    }
-    std::cout << "3333" << std::endl;
-    Eigen::MatrixXd V_deformed = m_V;
-    igl::arap_solve(m_bc, m_arap_data, V_deformed);
-
-    std::cout << "4444" << std::endl;
-    for (int i = 0; i < m_vertices.size(); ++i)
-        m_vertices[i].pos = V_deformed.row(i).transpose();
+void MeshData::setSkinningPreview(bool enabled) {
+    if (enabled == m_skinPreview) return;
+    m_skinPreview = enabled;
+
+    // Leaving shows the last uploaded pose again, entering blends the handles where they are now
+    if (!enabled) {
+        if (!isHeadless()) m_mesh->setSkinning(false);
+        return;
+    }
+    previewSkinnedPose();
+}
+
+void MeshData::computeSkinningWeights() {
+    const std::vector<int>& handles = selectedHandles();
+
+    m_pendingWeights++;
+    m_solver->computeWeights(Eigen::Map<const Eigen::VectorXi>(handles.data(), handles.size()),
+                             [this](const std::shared_ptr<HandleWeights>& weights) {
+        if (weights) {
+            std::atomic_store(&m_publishedWeights, weights); // Replaces weights that were not consumed yet
+        }
+        m_pendingWeights--;
+    });
+}
+
+void MeshData::consumeSkinningWeights() {
+    std::shared_ptr<HandleWeights> weights = std::atomic_exchange(&m_publishedWeights, std::shared_ptr<HandleWeights>());
+    if (weights) {
+        uploadSkinWeights(weights);
+    }
+}
+
+bool MeshData::skinningReady() {
+    if (!m_skinPreview || isHeadless()) return false;
+
+    const std::vector<int>& handles = selectedHandles();
+
+    // Weights belong to one handle set, a changed selection shows the plain pose until its own arrive
+    const bool current = m_skinWeights && m_skinWeights->handles.size() == static_cast<int>(handles.size()) &&
+                         std::equal(handles.begin(), handles.end(), m_skinWeights->handles.data());
+    if (!current) {
+        m_mesh->setSkinning(false);
+        if (!handles.empty() && m_pendingWeights == 0 && !m_uploadingWeights) computeSkinningWeights();
+    }
+    return current;
+}
+
+std::vector<int> MeshData::computeRoi(const std::vector<int>& handles, const std::vector<int>& moved) {
+    std::vector<int> region;
+    if (m_roiOptions.source == RoiSource::SelectedTriangles) {
+        std::vector<char> inRegion(m_vertices.size(), 0);
+        for (size_t t = 0; t < m_triangles.size(); ++t) {
+            if (!m_selectedTriangles[t]) continue;
+            HalfEdge* he = m_triangles[t].he;
+            for (int j = 0; j < 3; ++j) {
+                if (!inRegion[he->vertex->index]) {
+                    inRegion[he->vertex->index] = 1;
+                    region.push_back(he->vertex->index);
+                }
+                he = he->next;
+            }
+        }
+        return region;
+    }
+
+    // Seeds are the handles that moved, or all of them when the solve was requested without a drag
+    std::vector<char> isHandle(m_vertices.size(), 0);
+    for (int h : handles) isHandle[h] = 1;
+    std::vector<int> seeds;
+    for (int v : moved) {
+        if (isHandle[v]) {
+            seeds.push_back(v);
+            isHandle[v] = 0; // Once per seed
+        }
+    }
+    if (seeds.empty()) seeds = handles;
+
+    // Dijkstra over edge lengths of the rest pose, so the region does not shift while the handles move
+    const double radius = m_roiOptions.radius * m_restDiagonal;
+    std::vector<double> distance(m_vertices.size(), std::numeric_limits<double>::infinity());
+    typedef std::pair<double, int> Item;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+    for (int s : seeds) {
+        distance[s] = 0.0;
+        queue.push(Item(0.0, s));
+    }
+    while (!queue.empty()) {
+        Item item = queue.top();
+        queue.pop();
+        if (item.first > distance[item.second]) continue; // Stale entry
+        region.push_back(item.second);
+
+        const Vertex& v = m_vertices[item.second];
+        auto relax = [&](const Vertex& n) {
+            double d = item.first + (n.originalPos - v.originalPos).norm();
+            if (d <= radius && d < distance[n.index]) {
+                distance[n.index] = d;
+                queue.push(Item(d, n.index));
+            }
+        };
+        forEachIncoming(v, [&](HalfEdge* he) {
+            relax(*he->prev->vertex);
+            if (!he->twin) relax(*he->next->vertex); // Open ring, the outgoing boundary edge has no incoming twin
+        });
+    }
+    return region;
+}
+
+bool MeshData::solveRegion(const std::vector<int>& handles, const std::vector<int>& moved) {
+    PROFILE_SCOPE("Build ARAP region");
+    std::vector<int> region = computeRoi(handles, moved);
+
+    // Past half the mesh the full factorization, which is already cached, is the cheaper solve
+    if (region.empty() || region.size() * 2 > m_vertices.size()) {
+        return false;
+    }
+
+    // Local indices: the region first, then the ring of outside neighbours that pins it in place
+    std::vector<int> local(m_vertices.size(), -1);
+    std::vector<int> submesh(region);
+    for (size_t i = 0; i < region.size(); ++i) local[region[i]] = static_cast<int>(i);
 
-    std::cout << "5555" << std::endl;
-    // refreshPosition();
-    std::cout << "6666" << std::endl;
+    std::vector<char> faceMark(m_triangles.size(), 0);
+    std::vector<int> faces;
+    for (int idx : region) {
+        forEachIncoming(m_vertices[idx], [&](HalfEdge* he) {
+            const int f = he->face->index;
+            if (faceMark[f]) return;
+            faceMark[f] = 1;
+            faces.push_back(f);
+            for (int j = 0; j < 3; ++j) {
+                const int vi = m_F(f, j);
+                if (local[vi] < 0) {
+                    local[vi] = static_cast<int>(submesh.size());
+                    submesh.push_back(vi);
+                }
+            }
+        });
+    }
+
+    RegionSolveInput input;
+    input.vertices = Eigen::Map<Eigen::VectorXi>(submesh.data(), submesh.size());
+    input.faces.resize(faces.size(), 3);
+    for (size_t i = 0; i < faces.size(); ++i) {
+        for (int j = 0; j < 3; ++j) {
+            input.faces(i, j) = local[m_F(faces[i], j)];
+        }
+    }
+
+    // The ring stays where it is now, handles inside the region go to their current positions
+    std::vector<int> constrained;
+    for (size_t i = region.size(); i < submesh.size(); ++i) constrained.push_back(static_cast<int>(i));
+    for (int h : handles) {
+        if (local[h] >= 0 && local[h] < static_cast<int>(region.size())) constrained.push_back(local[h]);
+    }
+    input.handles = Eigen::Map<Eigen::VectorXi>(constrained.data(), constrained.size());
+    input.targets.resize(constrained.size(), 3);
+    for (size_t i = 0; i < constrained.size(); ++i) {
+        input.targets.row(i) = m_vertices[submesh[constrained[i]]].pos.transpose();
+    }
+
+    LOG_DEBUG("ARAP region: " << region.size() << " vertices, " << submesh.size() - region.size() << " fixed ring, " <<
+              faces.size() << " faces");
+    m_solver->solveRegion(input, m_arapSettings);
+    m_lastRoiVertexCount = static_cast<int>(region.size());
+    return true;
+}
+
+void MeshData::solveKeyframes(const std::vector<float>& times) {
+    const std::vector<int>& handles = selectedHandles();
+
+    // Handle targets are read here, the solver thread only sees these copies
+    std::vector<Eigen::MatrixXd> targets(times.size(), Eigen::MatrixXd(handles.size(), 3));
+    for (size_t t = 0; t < times.size(); ++t) {
+        for (int i = 0; i < handles.size(); ++i) {
+            targets[t].row(i) = m_vertices[handles[i]].getInterpolatedPos(times[t]).transpose();
+        }
+    }
+
+    m_solver->solveKeyframes(Eigen::Map<const Eigen::VectorXi>(handles.data(), handles.size()), times, targets);
+}
+
+bool MeshData::consumeSolverResults(float time) {
+    bool changed = false;
+    for (const std::shared_ptr<PoseSnapshot>& snapshot : m_solver->takeSnapshots()) {
+        // A result older than one already shown would move the mesh backwards
+        if (snapshot->version <= m_appliedPoseVersion) {
+            continue;
+        }
+        m_appliedPoseVersion = snapshot->version;
+
+        if (snapshot->vertices.size() > 0) {
+            std::vector<int> vertices(snapshot->vertices.size());
+            for (int i = 0; i < snapshot->vertices.size(); ++i) {
+                vertices[i] = snapshot->vertices[i];
+                m_vertices[vertices[i]].pos = snapshot->positions.row(i).transpose();
+            }
+            refreshPosition(vertices);
+            m_lastSolveStats = snapshot->stats;
+            LOG_TRACE("Applied region pose version " << snapshot->version << ", " << vertices.size() << " vertices");
+        }
+        else if (snapshot->keyframes.empty()) {
+            for (int i = 0; i < m_vertices.size(); ++i)
+                m_vertices[i].pos = snapshot->positions.row(i).transpose();
+            refreshPosition();
+            m_lastSolveStats = snapshot->stats;
+            LOG_TRACE("Applied pose version " << snapshot->version);
+        }
+        else {
+            for (size_t k = 0; k < snapshot->keyframes.size(); ++k) {
+                for (int i = 0; i < m_vertices.size(); ++i) {
+                    m_vertices[i].timeframePos[snapshot->keyframeTimes[k]] = snapshot->keyframes[k].row(i).transpose();
+                }
+            }
+            refreshPosition(time);
+        }
+        changed = true;
+    }
+
+    return changed;
 }
 
 void MeshData::storeAnimationFrames(const GenAPI::AnimationSequence& frames) {
-    std::cout << "Storing " << frames.size() << " animation frames..." << std::endl;
+    LOG_INFO("Storing " << frames.size() << " animation frames...");
+
+    // The worker only sees this snapshot, the live vertices are never written off the render thread
+    BakeInput input = snapshotForBake();
+
+    // The skinning preview only needs the handles, they get their generated keyframes now instead of after the bake
+    if (m_skinPreview) {
+        for (int i = 0; i < input.handles.size(); ++i) {
+            const int h = input.handles(i);
+            const Eigen::Vector3d base = input.basePositions.row(h).transpose();
+            Vertex& v = m_vertices[h];
+            v.timeframePos[0.0f] = base;
+            for (size_t frameIndex = 0; frameIndex < frames.size(); ++frameIndex) {
+                auto it = frames[frameIndex].find(h);
+                const Eigen::Vector3d delta = it == frames[frameIndex].end() ? Eigen::Vector3d::Zero() :
+                    Eigen::Vector3d(it->second.delta_x, it->second.delta_y, it->second.delta_z);
+                v.timeframePos[static_cast<float>(frameIndex + 1)] = base + delta;
+            }
+        }
+    }
+
+    m_pendingBakes++;
+    m_solver->bake(input, frames, [this](const std::shared_ptr<BakedAnimation>& baked) {
+        if (baked) {
+            publishAnimation(baked);
+        }
+        m_pendingBakes--;
+    });
+}
+
+BakeInput MeshData::snapshotForBake() {
+    BakeInput input;
+    input.restPositions = m_V;
+    input.faces = m_F;
+
+    input.basePositions.resize(m_vertices.size(), 3);
+    for (int i = 0; i < m_vertices.size(); ++i) {
+        input.basePositions.row(i) = m_vertices[i].pos.transpose();
+    }
+
+    const std::vector<int>& handles = selectedHandles();
+    input.handles = Eigen::Map<const Eigen::VectorXi>(handles.data(), handles.size());
+    input.dynamics = m_bakeDynamics;
+
+    return input;
+}
+
+void MeshData::publishAnimation(const std::shared_ptr<BakedAnimation>& baked) {
+    // Replaces any result that was not consumed yet, only the newest bake matters
+    std::atomic_store(&m_publishedAnimation, baked);
+}
+
+bool MeshData::consumePublishedAnimation() {
+    std::shared_ptr<BakedAnimation> baked = std::atomic_exchange(&m_publishedAnimation, std::shared_ptr<BakedAnimation>());
+    if (!baked) {
+        return false;
+    }
+
+    m_storedAnimationFrames = baked->frames;
 
-    // Store base positions before animation
     m_basePositions.clear();
     for (int i = 0; i < m_vertices.size(); ++i) {
-        m_basePositions[i] = m_vertices[i].pos;
-    }
-    std::cout << "Stored " << m_basePositions.size() << " base positions" << std::endl;
-
-    // Store animation frames
-    m_storedAnimationFrames = frames;
-
-    // Apply frames to timeframePos at integer time values
-    for (int frameIndex = 0; frameIndex < frames.size(); ++frameIndex) {
-        float timeframe = static_cast<float>(frameIndex + 1); // 1.0, 2.0, 3.0, etc.
-        std::cout << "Processing frame " << frameIndex << " for timeframe " << timeframe << std::endl;
-
-        int verticesWithDeltas = 0;
-        // Apply this frame's deltas to base positions
-        for (int i = 0; i < m_vertices.size(); ++i) {
-            Eigen::Vector3d newPos = m_basePositions[i]; // Start with base position
-
-            // Apply delta if this vertex is in this frame
-            const GenAPI::AnimationFrame& frame = frames[frameIndex];
-            auto it = frame.find(i);
-            if (it != frame.end()) {
-                const GenAPI::DeformationDelta& delta = it->second;
-                newPos += Eigen::Vector3d(delta.delta_x, delta.delta_y, delta.delta_z);
-                verticesWithDeltas++;
-                std::cout << "  Vertex " << i << " delta: (" << delta.delta_x << ", " << delta.delta_y << ", " << delta.delta_z << ")" << std::endl;
-            }
+        m_basePositions[i] = baked->basePositions.row(i).transpose();
+    }
 
-            // Store in vertex timeframe
-            m_vertices[i].timeframePos[timeframe] = newPos;
-            m_vertices[i].pos = newPos;
+    // Keyframe 0 is the pose the animation was generated from, frame i lands on timeframe i + 1
+    for (int i = 0; i < m_vertices.size(); ++i) {
+        Vertex& v = m_vertices[i];
+        v.timeframePos[0.0f] = m_basePositions[i];
+        for (size_t frameIndex = 0; frameIndex < baked->framePositions.size(); ++frameIndex) {
+            v.timeframePos[static_cast<float>(frameIndex + 1)] = baked->framePositions[frameIndex].row(i).transpose();
         }
-        std::cout << "AAAA" << std::endl;
-        computeARAP();
-        std::cout << "BBBB" << std::endl;
-        saveTimeFrame(timeframe);
-        std::cout << "Frame " << frameIndex << " applied deltas to " << verticesWithDeltas << " vertices" << std::endl;
     }
 
-    // Save initial frame at time 0
-    saveTimeFrame(0.0f);
-    std::cout << "Animation frames stored successfully!" << std::endl;
+    LOG_INFO("Animation frames stored successfully!");
+    return true;
 }
 
 void MeshData::applyAnimationFrame(int frameIndex) {
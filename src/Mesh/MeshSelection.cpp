@@ -1,43 +1,64 @@
 #include "MeshData.hpp"
+#include "../Utilities/Parallel.hpp"
+#include "../Utilities/Logger.hpp"
 
-#include <iostream>
 #include <limits>
+#include <mutex>
 
 void MeshData::resetSelection() {
     // Reset Selection Data
     std::fill(m_selectedEdges.begin(), m_selectedEdges.end(), false);
     std::fill(m_selectedVertices.begin(), m_selectedVertices.end(), false);
+    m_selectedHandlesDirty = true;
     std::fill(m_selectedTriangles.begin(), m_selectedTriangles.end(), false);
 
-    refreshTriangleColor(MeshVisMode::None);
+    markColorDirty(ColorDirtySelection); // Uploaded by the next updateTriangleColor
     refreshEdgeColor();
 }
 
+int MeshData::pickTriangle(const Eigen::Vector3f& org, const Eigen::Vector3f& dir, float& closest_t) {
+    std::mutex mutex;
+    int selected_triangle = -1;
+
+    // Closest hit per chunk, then the closest of those. Ties go to the lower index like the serial loop.
+    Parallel::forChunks(0, static_cast<int>(m_triangles.size()), [&](int chunkBegin, int chunkEnd) {
+        float chunk_t = std::numeric_limits<float>::max();
+        int chunk_triangle = -1;
+        for (int i = chunkBegin; i < chunkEnd; ++i) {
+            Eigen::Vector3f intersectPoint;
+            float t;
+            bool hit = rayIntersectTriangle(org, dir, m_triangles[i], intersectPoint, t);
+            if (hit && t > 1e-6f && t < chunk_t) {
+                chunk_t = t;
+                chunk_triangle = i;
+            }
+        }
+
+        if (chunk_triangle == -1) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        if (chunk_t < closest_t || (chunk_t == closest_t && chunk_triangle < selected_triangle)) {
+            closest_t = chunk_t;
+            selected_triangle = chunk_triangle;
+        }
+    }, 4096, "pick");
+
+    return selected_triangle;
+}
+
 void MeshData::selectTriangle(const Eigen::Vector3f& cam_org, const Eigen::Vector3f& nearPoint) {
 
     Eigen::Vector3f ray_dir = (nearPoint - cam_org).normalized();
 
     float closest_t = std::numeric_limits<float>::max();
-    int selected_triangle = -1;
-
-    for (size_t i = 0; i < m_triangles.size(); ++i) {
-        const Triangle& tri = m_triangles[i];
-        Eigen::Vector3f intersectPoint;
-        float t;
-        bool hit = rayIntersectTriangle(cam_org, ray_dir, tri, intersectPoint, t);
-        if (hit && t > 1e-6f && t < closest_t) {
-            closest_t = t;
-            selected_triangle = static_cast<int>(i);
-        }
-    }
+    int selected_triangle = pickTriangle(cam_org, ray_dir, closest_t);
 
     if (selected_triangle != -1) {
-        std::cout << "Hit triangle " << selected_triangle << " at t = " << closest_t << "\n";
+        LOG_DEBUG("Hit triangle " << selected_triangle << " at t = " << closest_t);
 
         m_selectedTriangles[selected_triangle] = true;
-        changeTriangleColor(selected_triangle, Eigen::Vector3f(0.0f, 0.0f, 1.0f));
+        markColorDirty(ColorDirtySelection);
     } else {
-        std::cout << "No triangle hit\n";
+        LOG_DEBUG("No triangle hit");
     }
 }
 
@@ -45,18 +66,7 @@ int MeshData::selectVertex(const Eigen::Vector3f& cam_org, const Eigen::Vector3f
     Eigen::Vector3f ray_dir = (nearPoint - cam_org).normalized();
 
     float closest_t = std::numeric_limits<float>::max();
-    int selected_triangle = -1;
-
-    for (size_t i = 0; i < m_triangles.size(); ++i) {
-        const Triangle& tri = m_triangles[i];
-        Eigen::Vector3f intersectPoint;
-        float t;
-        bool hit = rayIntersectTriangle(cam_org, ray_dir, tri, intersectPoint, t);
-        if (hit && t > 1e-6f && t < closest_t) {
-            closest_t = t;
-            selected_triangle = static_cast<int>(i);
-        }
-    }
+    int selected_triangle = pickTriangle(cam_org, ray_dir, closest_t);
 
     Eigen::Vector3f intersectPoint = cam_org + ray_dir * closest_t;
     float closest_dist = std::numeric_limits<float>::max();
@@ -74,6 +84,7 @@ int MeshData::selectVertex(const Eigen::Vector3f& cam_org, const Eigen::Vector3f
         }
 
         m_selectedVertices[selected_vertex] = !m_selectedVertices[selected_vertex];
+        m_selectedHandlesDirty = true;
         lastSelectedVertex = selected_vertex;
 
     } else lastSelectedVertex = -1;
@@ -87,7 +98,19 @@ int MeshData::selectVertex(const Eigen::Vector3f& cam_org, const Eigen::Vector3f
 void MeshData::deselectVertex(int index) {
     if (index >= 0 && index < m_selectedVertices.size()) {
         m_selectedVertices[index] = false;
+        m_selectedHandlesDirty = true;
+    }
+}
+
+const std::vector<int>& MeshData::selectedHandles() {
+    if (m_selectedHandlesDirty) {
+        m_selectedHandles.clear();
+        for (int i = 0; i < m_selectedVertices.size(); ++i) {
+            if (m_selectedVertices[i]) m_selectedHandles.push_back(i);
+        }
+        m_selectedHandlesDirty = false;
     }
+    return m_selectedHandles;
 }
 
 bool MeshData::rayIntersectTriangle(const Eigen::Vector3f& org, const Eigen::Vector3f& dir, const Triangle& tri,
@@ -1,18 +1,20 @@
 #include "Renderer.hpp"
+#include "Utilities/GpuProfiler.hpp"
+#include "Utilities/Logger.hpp"
 
 Renderer::Renderer()
 {
-    std::cout << "Initializing Shaders" << std::endl;
+    LOG_INFO("Initializing Shaders");
     initShaders();
-    std::cout << "Initializing Models" << std::endl;
+    LOG_INFO("Initializing Models");
     initModels();
-    std::cout << "Finish Initialization" << std::endl;
+    LOG_INFO("Finish Initialization");
 
 
-    std::cout << "Eigen version: "
-              << EIGEN_WORLD_VERSION << "."
-              << EIGEN_MAJOR_VERSION << "."
-              << EIGEN_MINOR_VERSION << std::endl;
+    LOG_INFO("Eigen version: "
+             << EIGEN_WORLD_VERSION << "."
+             << EIGEN_MAJOR_VERSION << "."
+             << EIGEN_MINOR_VERSION);
     // return 0;
 }
 
@@ -39,9 +41,28 @@ void Renderer::initModels()
 
 void Renderer::draw(const CameraParam& cameraParam)
 {
-    m_plane->draw(cameraParam);
-    m_meshData->draw(cameraParam);
+    PROFILE_SCOPE("Renderer::draw");
+
+    {
+        PROFILE_GPU_SCOPE("Draw plane");
+        m_plane->draw(cameraParam);
+    }
+    {
+        PROFILE_GPU_SCOPE("Draw mesh");
+        m_meshData->draw(cameraParam);
+    }
     if (m_meshData->getLastSelectedVertex() != -1) {
+        PROFILE_GPU_SCOPE("Draw gizmo");
         m_gizmo->draw(cameraParam);
     }
 }
+
+MemoryStats::Report Renderer::collectMemoryUsage()
+{
+    MemoryStats::Report report;
+    m_meshData->collectMemoryUsage(report);
+    MemoryStats::add(report, "GPU", "Plane VBO", 1, m_plane->getVBOBytes());
+    MemoryStats::add(report, "GPU", "Gizmo VBO", 1, m_gizmo->getAxis()->getVBOBytes());
+    MemoryStats::add(report, "GPU", "Gizmo EBO", 1, m_gizmo->getAxis()->getEBOBytes());
+    return report;
+}
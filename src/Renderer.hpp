@@ -34,6 +34,8 @@ public:
     MeshData* getMeshData() { return m_meshData; }
     Gizmo* getGizmo() { return m_gizmo; }
 
+    MemoryStats::Report collectMemoryUsage();
+
 public:
 };
 
@@ -0,0 +1,214 @@
+#include "Session.hpp"
+#include "Utilities/Logger.hpp"
+
+#include <cstring>
+
+namespace {
+    const char kMagic[8] = { 'A', 'U', 'C', 'A', 'D', 'S', 'E', 'S' };
+    const uint32_t kVersion = 1;
+
+    template <typename T>
+    bool read(std::ifstream& file, T& value) {
+        char bytes[sizeof(T)];
+        if (!file.read(bytes, sizeof(T))) return false;
+        sessionByteOrder(bytes, sizeof(T));
+        memcpy(&value, bytes, sizeof(T));
+        return true;
+    }
+}
+
+// SessionRecorder ====================================================================================
+bool SessionRecorder::open(const std::string& path, int width, int height) {
+    m_file.open(path, std::ios::binary | std::ios::trunc);
+    if (!m_file.is_open()) {
+        LOG_ERROR("Failed to create session log: " << path);
+        return false;
+    }
+
+    m_file.write(kMagic, sizeof(kMagic));
+    write(kVersion);
+    write(static_cast<int32_t>(width));
+    write(static_cast<int32_t>(height));
+    LOG_INFO("Recording session to " << path);
+    return true;
+}
+
+void SessionRecorder::close() {
+    if (m_file.is_open()) {
+        m_file.close();
+    }
+}
+
+void SessionRecorder::frame(double time, float delta) {
+    if (!isOpen()) return;
+    writeType(SessionEventType::Frame);
+    write(time);
+    write(delta);
+}
+
+void SessionRecorder::actions(uint32_t bits) {
+    if (!isOpen() || bits == 0) return;
+    writeType(SessionEventType::Actions);
+    write(bits);
+}
+
+void SessionRecorder::cursorPos(double x, double y) {
+    if (!isOpen()) return;
+    writeType(SessionEventType::CursorPos);
+    write(static_cast<float>(x));
+    write(static_cast<float>(y));
+}
+
+void SessionRecorder::mouseButton(int button, int action, int mods) {
+    if (!isOpen()) return;
+    writeType(SessionEventType::MouseButton);
+    write(static_cast<int8_t>(button));
+    write(static_cast<int8_t>(action));
+    write(static_cast<int8_t>(mods));
+}
+
+void SessionRecorder::scroll(double x, double y) {
+    if (!isOpen()) return;
+    writeType(SessionEventType::Scroll);
+    write(static_cast<float>(x));
+    write(static_cast<float>(y));
+}
+
+void SessionRecorder::key(int key, int scancode, int action, int mods) {
+    if (!isOpen()) return;
+    writeType(SessionEventType::Key);
+    write(static_cast<int16_t>(key));
+    write(static_cast<int16_t>(scancode));
+    write(static_cast<int8_t>(action));
+    write(static_cast<int8_t>(mods));
+}
+
+void SessionRecorder::character(unsigned int codepoint) {
+    if (!isOpen()) return;
+    writeType(SessionEventType::Char);
+    write(static_cast<uint32_t>(codepoint));
+}
+
+void SessionRecorder::resize(int width, int height) {
+    if (!isOpen()) return;
+    writeType(SessionEventType::Resize);
+    write(static_cast<int32_t>(width));
+    write(static_cast<int32_t>(height));
+}
+
+void SessionRecorder::focus(int focused) {
+    if (!isOpen()) return;
+    writeType(SessionEventType::Focus);
+    write(static_cast<int8_t>(focused));
+}
+
+void SessionRecorder::cursorEnter(int entered) {
+    if (!isOpen()) return;
+    writeType(SessionEventType::CursorEnter);
+    write(static_cast<int8_t>(entered));
+}
+
+// SessionPlayer ======================================================================================
+bool SessionPlayer::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        LOG_ERROR("Failed to open session log: " << path);
+        return false;
+    }
+
+    char magic[sizeof(kMagic)];
+    uint32_t version = 0;
+    int32_t width = 0, height = 0;
+    if (!file.read(magic, sizeof(magic)) || memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+        !read(file, version) || version != kVersion || !read(file, width) || !read(file, height)) {
+        LOG_ERROR("Not a session log (or an unsupported version): " << path);
+        return false;
+    }
+    m_width = width;
+    m_height = height;
+    m_frames.clear();
+
+    std::vector<SessionEvent> pending;
+    uint8_t type;
+    while (read(file, type)) {
+        SessionEvent event;
+        event.type = static_cast<SessionEventType>(type);
+        bool ok = true;
+
+        switch (event.type) {
+            case SessionEventType::Frame: {
+                SessionFrame frame;
+                ok = read(file, frame.time) && read(file, frame.delta);
+                if (ok) {
+                    frame.events.swap(pending);
+                    m_frames.push_back(std::move(frame));
+                }
+                continue;
+            }
+            case SessionEventType::Actions: {
+                uint32_t bits = 0;
+                ok = read(file, bits);
+                if (ok && !m_frames.empty()) {
+                    m_frames.back().actions = bits;
+                }
+                continue;
+            }
+            case SessionEventType::CursorPos:
+            case SessionEventType::Scroll: {
+                float x = 0.0f, y = 0.0f;
+                ok = read(file, x) && read(file, y);
+                event.x = x;
+                event.y = y;
+                break;
+            }
+            case SessionEventType::MouseButton: {
+                int8_t button = 0, action = 0, mods = 0;
+                ok = read(file, button) && read(file, action) && read(file, mods);
+                event.a = button;
+                event.action = action;
+                event.mods = mods;
+                break;
+            }
+            case SessionEventType::Key: {
+                int16_t key = 0, scancode = 0;
+                int8_t action = 0, mods = 0;
+                ok = read(file, key) && read(file, scancode) && read(file, action) && read(file, mods);
+                event.a = key;
+                event.b = scancode;
+                event.action = action;
+                event.mods = mods;
+                break;
+            }
+            case SessionEventType::Char: {
+                uint32_t codepoint = 0;
+                ok = read(file, codepoint);
+                event.a = static_cast<int>(codepoint);
+                break;
+            }
+            case SessionEventType::Resize: {
+                int32_t w = 0, h = 0;
+                ok = read(file, w) && read(file, h);
+                event.a = w;
+                event.b = h;
+                break;
+            }
+            case SessionEventType::Focus:
+            case SessionEventType::CursorEnter: {
+                int8_t value = 0;
+                ok = read(file, value);
+                event.a = value;
+                break;
+            }
+            default:
+                LOG_WARN("Unknown record " << static_cast<int>(type) << " in session log, stopping there");
+                ok = false;
+                break;
+        }
+
+        if (!ok) break; // Truncated log, e.g. the app was killed while recording
+        pending.push_back(event);
+    }
+
+    LOG_INFO("Loaded session " << path << ": " << m_frames.size() << " frames");
+    return !m_frames.empty();
+}
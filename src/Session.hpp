@@ -0,0 +1,114 @@
+#ifndef SESSION_HPP
+#define SESSION_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Input session logs: every GLFW event the Engine receives plus one marker per drawn frame.
+// Replaying feeds the events back through ImGui's GLFW backend frame by frame, with the recorded
+// clock and frame deltas, so a slow session can be repeated as a profiling run.
+//
+// File layout (little endian):
+//   header  "AUCADSES" | u32 version | i32 width | i32 height
+//   records u8 type | payload, see SessionEventType
+// Events belong to the next Frame record.
+
+enum class SessionEventType : uint8_t {
+    Frame       = 0,    // f64 glfw time | f32 frame delta
+    Actions     = 1,    // u32 SessionAction bits raised by the interface in the preceding frame
+    CursorPos   = 2,    // f32 x | f32 y
+    MouseButton = 3,    // i8 button | i8 action | i8 mods
+    Scroll      = 4,    // f32 x | f32 y
+    Key         = 5,    // i16 key | i16 scancode | i8 action | i8 mods
+    Char        = 6,    // u32 codepoint
+    Resize      = 7,    // i32 width | i32 height
+    Focus       = 8,    // i8 focused
+    CursorEnter = 9     // i8 entered
+};
+
+// One-shot interface actions, recorded to check that a replay went the same way
+enum SessionAction : uint32_t {
+    SessionActionCompute        = 1 << 0,
+    SessionActionSolveAll       = 1 << 1,
+    SessionActionRefresh        = 1 << 2,
+    SessionActionSaveTimeframe  = 1 << 3
+};
+
+struct SessionEvent {
+    SessionEventType type;
+    double x = 0.0, y = 0.0;   // CursorPos, Scroll
+    int a = 0, b = 0;          // Button/key and scancode, codepoint, width/height, focused/entered
+    int action = 0, mods = 0;
+};
+
+struct SessionFrame {
+    double time = 0.0;      // glfwGetTime() when the frame started
+    float delta = 0.0f;     // Seconds since the previous frame, what playback advanced by
+    uint32_t actions = 0;
+    std::vector<SessionEvent> events;
+};
+
+struct SessionOptions {
+    std::string recordPath;
+    std::string replayPath;
+    bool replayFast = false;    // Ignore the recorded timing and draw frames back to back
+    bool replaySync = true;     // Wait for solves, bakes and requests before every frame so results land on the same frame
+    std::string tracePath;      // Chrome trace of the whole run
+};
+
+// Values are stored least significant byte first, this swaps them on big endian hosts (IEEE floats included)
+inline void sessionByteOrder(char* bytes, size_t size) {
+    const uint16_t probe = 1;
+    if (*reinterpret_cast<const unsigned char*>(&probe) == 0) std::reverse(bytes, bytes + size);
+}
+
+class SessionRecorder {
+private:
+    std::ofstream m_file;
+
+    void writeType(SessionEventType type) { write(static_cast<uint8_t>(type)); }
+    template <typename T>
+    void write(T value) {
+        char bytes[sizeof(T)];
+        memcpy(bytes, &value, sizeof(T));
+        sessionByteOrder(bytes, sizeof(T));
+        m_file.write(bytes, sizeof(T));
+    }
+
+public:
+    bool open(const std::string& path, int width, int height);
+    void close();
+    bool isOpen() const { return m_file.is_open(); }
+
+    void frame(double time, float delta);
+    void actions(uint32_t bits);
+    void cursorPos(double x, double y);
+    void mouseButton(int button, int action, int mods);
+    void scroll(double x, double y);
+    void key(int key, int scancode, int action, int mods);
+    void character(unsigned int codepoint);
+    void resize(int width, int height);
+    void focus(int focused);
+    void cursorEnter(int entered);
+};
+
+class SessionPlayer {
+private:
+    std::vector<SessionFrame> m_frames;
+    int m_width, m_height;
+
+public:
+    SessionPlayer() : m_width(0), m_height(0) {}
+
+    bool load(const std::string& path);
+
+    const std::vector<SessionFrame>& getFrames() const { return m_frames; }
+    int getWidth() const { return m_width; }
+    int getHeight() const { return m_height; }
+};
+
+#endif // SESSION_HPP
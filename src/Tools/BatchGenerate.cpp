@@ -0,0 +1,339 @@
+// Headless batch generation: mesh + list of prompts in, baked ARAP frames out.
+// No window or GL context is created, so this runs on CI machines without a display.
+//
+// Jobs file:
+// {
+//   "control_points": [ { "id": 120, "role": "left hand" }, ... ],   // default for every job
+//   "jobs": [
+//     { "name": "wave", "prompt": "make the character wave", "length": 6 },
+//     { "name": "jump", "prompt": "character jumps", "length": 8, "control_points": [ ... ] }
+//   ]
+// }
+// Job names become directory names under --out. They may only use letters, digits, '-', '_' and '.'
+// (not as the first character), and must be unique.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../GenAPI/GenAPI.hpp"
+#include "../GenAPI/GenQueue.hpp"
+#include "../GenAPI/json.hpp"
+#include "../Mesh/AnimationBaker.hpp"
+#include "../Mesh/MeshLoader.hpp"
+#include "../Utilities/Profiler.hpp"
+#include "../Utilities/FileSystem.hpp"
+#include "../Utilities/TaskScheduler.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+    struct Options {
+        std::string meshPath;
+        std::string jobsPath;
+        std::string outDir = "./batch_output";
+        std::string apiUrl = "http://localhost:8080";
+        std::string cacheDir;
+        std::string tracePath; // Chrome trace of the whole run, empty = off
+        int concurrency = 2;
+        int threads = 0; // CPU workers for loading and baking, 0 = one per core
+        BakeDynamics dynamics;
+    };
+
+    void printUsage(const char* program) {
+        std::cout << "Usage: " << program << " --mesh <file> --jobs <jobs.json> [options]\n"
+                  << "  --out <dir>          Output directory (default ./batch_output)\n"
+                  << "  --api <url>          Generation API (default http://localhost:8080)\n"
+                  << "  --cache <dir>        Response cache directory\n"
+                  << "  --concurrency <n>    Requests in flight (default 2)\n"
+                  << "  --threads <n>        CPU worker threads (default one per core)\n"
+                  << "  --trace <file>       Write a Chrome trace of the run\n"
+                  << "  --dynamics           Bake with secondary motion\n"
+                  << "  --substeps <n>       Dynamics time steps per frame (default 4)\n"
+                  << "  --inertia <x>        Dynamics inertia relative to the stiffness (default 0.1)\n"
+                  << "  --damping <x>        Fraction of the velocity lost per frame (default 0.2)\n";
+    }
+
+    bool parseArgs(int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+
+            if (arg == "--mesh" && hasValue) options.meshPath = argv[++i];
+            else if (arg == "--jobs" && hasValue) options.jobsPath = argv[++i];
+            else if (arg == "--out" && hasValue) options.outDir = argv[++i];
+            else if (arg == "--api" && hasValue) options.apiUrl = argv[++i];
+            else if (arg == "--cache" && hasValue) options.cacheDir = argv[++i];
+            else if (arg == "--concurrency" && hasValue) options.concurrency = std::atoi(argv[++i]);
+            else if (arg == "--threads" && hasValue) options.threads = std::atoi(argv[++i]);
+            else if (arg == "--trace" && hasValue) options.tracePath = argv[++i];
+            else if (arg == "--dynamics") options.dynamics.enabled = true;
+            else if (arg == "--substeps" && hasValue) options.dynamics.substeps = std::atoi(argv[++i]);
+            else if (arg == "--inertia" && hasValue) options.dynamics.inertia = std::atof(argv[++i]);
+            else if (arg == "--damping" && hasValue) options.dynamics.damping = std::atof(argv[++i]);
+            else {
+                std::cerr << "Unknown argument: " << arg << std::endl;
+                return false;
+            }
+        }
+        return !options.meshPath.empty() && !options.jobsPath.empty();
+    }
+
+    // Names come from the jobs file and end up in paths, so no separators, no "..", nothing hidden
+    bool isValidJobName(const std::string& name) {
+        if (name.empty() || name[0] == '.') return false;
+        for (char c : name) {
+            const bool allowed = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')
+                || c == '-' || c == '_' || c == '.';
+            if (!allowed) return false;
+        }
+        return true;
+    }
+
+    // Schema checks, everything main reads from the jobs file is checked here first so the
+    // accessors below can't throw (or assert, for missing keys on a const json)
+    bool validateControlPoints(const json& array, const std::string& where) {
+        if (!array.is_array()) {
+            std::cerr << where << ": \"control_points\" must be an array" << std::endl;
+            return false;
+        }
+        for (const auto& cp : array) {
+            if (!cp.is_object() || !cp.contains("id") || !cp["id"].is_number_integer()) {
+                std::cerr << where << ": every control point needs an integer \"id\"" << std::endl;
+                return false;
+            }
+            if (cp.contains("role") && !cp["role"].is_string()) {
+                std::cerr << where << ": control point \"role\" must be a string" << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool validateJobs(const json& root, std::vector<std::string>& names) {
+        if (!root.is_object() || !root.contains("jobs") || !root["jobs"].is_array()) {
+            std::cerr << "Jobs file must be an object with a \"jobs\" array" << std::endl;
+            return false;
+        }
+        if (root.contains("control_points") && !validateControlPoints(root["control_points"], "Jobs file")) {
+            return false;
+        }
+
+        std::set<std::string> seen;
+        int index = 0;
+        for (const auto& jobJson : root["jobs"]) {
+            const std::string where = "Job " + std::to_string(index);
+            if (!jobJson.is_object()) {
+                std::cerr << where << ": must be an object" << std::endl;
+                return false;
+            }
+            if (jobJson.contains("name") && !jobJson["name"].is_string()) {
+                std::cerr << where << ": \"name\" must be a string" << std::endl;
+                return false;
+            }
+            if (!jobJson.contains("prompt") || !jobJson["prompt"].is_string()) {
+                std::cerr << where << ": \"prompt\" must be a string" << std::endl;
+                return false;
+            }
+            if (jobJson.contains("length") && (!jobJson["length"].is_number_integer() || jobJson["length"].get<long long>() <= 0
+                || jobJson["length"].get<long long>() > std::numeric_limits<int>::max())) {
+                std::cerr << where << ": \"length\" must be a positive integer" << std::endl;
+                return false;
+            }
+            if (jobJson.contains("control_points") && !validateControlPoints(jobJson["control_points"], where)) {
+                return false;
+            }
+
+            const std::string name = jobJson.contains("name") ? jobJson["name"].get<std::string>() : "job_" + std::to_string(index);
+            if (!isValidJobName(name)) {
+                std::cerr << where << ": invalid name \"" << name << "\", use letters, digits, '-', '_' and '.'" << std::endl;
+                return false;
+            }
+            if (!seen.insert(name).second) {
+                std::cerr << where << ": duplicate name \"" << name << "\"" << std::endl;
+                return false;
+            }
+            names.push_back(name);
+            index++;
+        }
+        return true;
+    }
+
+    // Expects an array that passed validateControlPoints
+    std::vector<GenAPI::ControlPoint> parseControlPoints(const json& array, const Eigen::MatrixXd& V) {
+        std::vector<GenAPI::ControlPoint> controlPoints;
+        for (const auto& cp : array) {
+            const int id = cp["id"].get<int>();
+            if (id < 0 || id >= V.rows()) {
+                std::cerr << "Skipping control point " << id << ", out of range" << std::endl;
+                continue;
+            }
+            const std::string role = GenAPI::roleFromVertexDescription(cp.contains("role") ? cp["role"].get<std::string>() : std::string());
+            controlPoints.emplace_back(id, role, V.row(id).transpose().cast<float>());
+        }
+        return controlPoints;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseArgs(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    TaskScheduler::instance().setWorkerCount(options.threads);
+
+    Profiler::setThreadName("main");
+    if (!options.tracePath.empty()) {
+        Profiler::startTrace();
+    }
+
+    // Mesh
+    std::vector<Eigen::Vector3f> vertices, normals;
+    std::vector<Eigen::Vector3i> indices;
+    if (!MeshLoader::load(options.meshPath, vertices, normals, indices)) {
+        return 1;
+    }
+
+    Eigen::MatrixXd V;
+    Eigen::MatrixXi F;
+    MeshLoader::toMatrices(vertices, indices, V, F);
+    std::cout << "Mesh: " << V.rows() << " vertices, " << F.rows() << " faces" << std::endl;
+
+    // Jobs
+    json jobsJson;
+    try {
+        std::ifstream jobsFile(options.jobsPath);
+        jobsJson = json::parse(jobsFile);
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to read jobs file " << options.jobsPath << ": " << e.what() << std::endl;
+        return 1;
+    }
+
+    GenAPI::DeformationGenerator generator(options.apiUrl);
+    if (!options.cacheDir.empty()) {
+        generator.setCacheDirectory(options.cacheDir);
+    }
+
+    // Validate the whole file before anything is submitted, a bad entry shouldn't cost the requests before it
+    std::vector<std::string> names;
+    if (!validateJobs(jobsJson, names)) {
+        return 1;
+    }
+
+    if (!FileSystem::makeDirectory(options.outDir)) {
+        std::cerr << "Failed to create output directory " << options.outDir << std::endl;
+        return 1;
+    }
+
+    std::vector<GenAPI::ControlPoint> defaultControlPoints;
+    if (jobsJson.contains("control_points")) {
+        defaultControlPoints = parseControlPoints(jobsJson["control_points"], V);
+    }
+
+    std::map<int, std::string> jobNames;
+    {
+        GenAPI::GenerationQueue queue(generator, options.concurrency);
+
+        int index = 0;
+        for (const auto& jobJson : jobsJson["jobs"]) {
+            std::vector<GenAPI::ControlPoint> controlPoints = jobJson.contains("control_points")
+                ? parseControlPoints(jobJson["control_points"], V)
+                : defaultControlPoints;
+
+            const int length = jobJson.contains("length") ? jobJson["length"].get<int>() : 1;
+            GenAPI::GenerationRequest request(controlPoints, jobJson["prompt"].get<std::string>(), length);
+            const int id = queue.submit(request);
+            jobNames[id] = names[index];
+            index++;
+        }
+
+        std::cout << "Submitted " << jobNames.size() << " jobs" << std::endl;
+
+        json summary = json::array();
+        int failed = 0;
+        size_t finished = 0;
+
+        // Bake each result as it comes in while the remaining requests are still in flight
+        while (finished < jobNames.size()) {
+            GenAPI::GenerationJobPtr job;
+            if (!queue.popFinished(job)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                continue;
+            }
+            finished++;
+
+            const std::string& name = jobNames[job->id];
+            json entry;
+            entry["name"] = name;
+            entry["prompt"] = job->request.prompt;
+            entry["status"] = GenAPI::jobStatusName(job->status);
+            entry["request_seconds"] = job->elapsedSeconds;
+            entry["from_cache"] = job->response.from_cache;
+
+            if (job->status != GenAPI::JobStatus::Done) {
+                std::cerr << "[" << name << "] " << job->response.error_message << std::endl;
+                entry["error"] = job->response.error_message;
+                summary.push_back(entry);
+                failed++;
+                continue;
+            }
+
+            BakeInput input;
+            input.restPositions = V;
+            input.faces = F;
+            input.basePositions = V;
+            input.handles.resize(job->request.control_points.size());
+            for (size_t i = 0; i < job->request.control_points.size(); ++i) {
+                input.handles(i) = job->request.control_points[i].id;
+            }
+            input.dynamics = options.dynamics;
+
+            auto bakeStart = std::chrono::steady_clock::now();
+            std::shared_ptr<BakedAnimation> baked = AnimationBaker::bake(input, job->response.animation_frames);
+            double bakeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - bakeStart).count();
+
+            // frame_000 is the rest pose, frame_i is timeframe i like in the viewer
+            const std::string jobDir = options.outDir + "/" + name;
+            if (!FileSystem::makeDirectory(jobDir)) {
+                std::cerr << "[" << name << "] Failed to create " << jobDir << std::endl;
+                entry["error"] = "Failed to create " + jobDir;
+                summary.push_back(entry);
+                failed++;
+                continue;
+            }
+            MeshLoader::writePLY(jobDir + "/frame_000.ply", baked->basePositions, F);
+            for (size_t i = 0; i < baked->framePositions.size(); ++i) {
+                char fileName[32];
+                snprintf(fileName, sizeof(fileName), "/frame_%03d.ply", static_cast<int>(i + 1));
+                MeshLoader::writePLY(jobDir + fileName, baked->framePositions[i], F);
+            }
+
+            entry["frames"] = baked->framePositions.size();
+            entry["bake_seconds"] = bakeSeconds;
+            entry["directory"] = jobDir;
+            summary.push_back(entry);
+
+            std::cout << "[" << name << "] " << baked->framePositions.size() << " frames baked in "
+                      << bakeSeconds << "s" << std::endl;
+        }
+
+        std::ofstream summaryFile(options.outDir + "/summary.json");
+        summaryFile << summary.dump(2);
+
+        std::cout << "Done: " << (jobNames.size() - failed) << " succeeded, " << failed << " failed" << std::endl;
+        if (!options.tracePath.empty()) {
+            Profiler::writeChromeTrace(options.tracePath);
+        }
+        return failed == 0 ? 0 : 1;
+    }
+}
@@ -0,0 +1,447 @@
+// Benchmark suite over the bundled meshes, no window or GL context.
+// Every step runs a warm-up pass and then --repeat timed passes on the same input, so two builds of
+// the same commit on the same machine give comparable numbers. Results go out as JSON:
+// {
+//   "version": "1.0.0", "threads": 8, "repeat": 10, "peak_rss_kb": 182340,
+//   "meshes": [
+//     { "name": "bunny.ply", "vertices": 8171, "faces": 16301, "rss_kb": 80412,
+//       "steps": { "load": { "median_ms": 12.3, "mean_ms": 12.5, "stddev_ms": 0.4, "min_ms": 12.0, "max_ms": 13.4 }, ... },
+//       "arap_convergence": { "single_level": [ { "iteration": 1, "ms": 80.1, "energy": 0.41 }, ... ],
+//                             "hierarchical": { "ms": 35.2, "energy": 0.12, "levels": [ ... ] },
+//                             "single_level_ms_to_match": 410.3, "speedup": 11.7 } },
+//     ...
+//   ]
+// }
+//
+// Steps:
+//   load                    MeshLoader::load
+//   halfedge_build          Headless MeshData from the loaded arrays, includes the first attribute pass
+//   geometry_attributes     Cotangent weights, areas and mean curvature
+//   arap_precompute         igl::arap_precomputation with a fixed handle set
+//   arap_solve              igl::arap_solve with one handle moved
+//   arap_hierarchy_build    ArapHierarchy decimation and coarse factorizations for the same handles
+//   arap_hierarchical_solve Coarse to fine solve of the same edit, kFineIterations per finer level
+//   bake                    AnimationBaker::bake of kBakeFrames frames swinging the first handle
+//   bake_dynamics           The same sequence integrated with BakeDynamics defaults
+//   pick                    kPickRays ray casts from around the mesh
+//   keyframe_interpolation  Every vertex evaluated at kInterpolationSamples times over 11 keyframes
+//   response_parse          parseResponseJson on a synthetic response of kResponseFrames frames
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include <igl/arap.h>
+
+#include "../GenAPI/GenAPI.hpp"
+#include "../GenAPI/json.hpp"
+#include "../Mesh/ArapHierarchy.hpp"
+#include "../Mesh/MeshData.hpp"
+#include "../Mesh/MeshLoader.hpp"
+#include "../Utilities/Logger.hpp"
+#include "../Utilities/MemoryStats.hpp"
+#include "../Utilities/TaskScheduler.hpp"
+
+#ifndef APP_VERSION
+#define APP_VERSION "unknown"
+#endif
+
+using json = nlohmann::json;
+
+namespace {
+    const int kPickRays = 256;
+    const int kInterpolationSamples = 32;
+    const int kResponseFrames = 10;
+    const int kResponseVertices = 1000; // Deltas per frame, capped by the vertex count
+    const int kFineIterations = 2;
+    const int kConvergenceIterations = 20; // Single level iterations the hierarchical result is compared against
+    const int kBakeFrames = 20;
+
+    // Bundled assets, smallest to largest
+    const char* kDefaultMeshes[] = {
+        "tetrahedron.ply", "octahedron.ply", "icosahedron.ply", "quist.ply", "sphere.ply", "torus.ply",
+        "armadillo.ply", "feline.ply", "bunny.ply", "dragon.ply", "happy.ply"
+    };
+
+    struct Options {
+        std::string assetsDir = "assets";
+        std::vector<std::string> meshes; // Empty = every bundled mesh
+        std::string jsonOut;             // Empty = stdout
+        int repeat = 10;
+        int threads = 0;                 // 0 = one per core
+    };
+
+    void printUsage(const char* program) {
+        std::cout << "Usage: " << program << " [options]\n"
+                  << "  --assets <dir>     Directory of the meshes (default assets)\n"
+                  << "  --mesh <file>      Only this mesh from the assets directory, may be repeated\n"
+                  << "  --repeat <n>       Timed runs per step (default 10)\n"
+                  << "  --threads <n>      CPU worker threads (default one per core)\n"
+                  << "  --json <file>      Write the results here instead of stdout\n";
+    }
+
+    bool parseArgs(int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+
+            if (arg == "--assets" && hasValue) options.assetsDir = argv[++i];
+            else if (arg == "--mesh" && hasValue) options.meshes.push_back(argv[++i]);
+            else if (arg == "--repeat" && hasValue) options.repeat = std::atoi(argv[++i]);
+            else if (arg == "--threads" && hasValue) options.threads = std::atoi(argv[++i]);
+            else if (arg == "--json" && hasValue) options.jsonOut = argv[++i];
+            else return false;
+        }
+        return options.repeat > 0;
+    }
+
+    // Memory ======================================================================================
+    long peakRssKb() {
+#if defined(_WIN32)
+        return 0;
+#else
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+        return usage.ru_maxrss / 1024; // Bytes on macOS
+#else
+        return usage.ru_maxrss;
+#endif
+#endif
+    }
+
+    // Timing ======================================================================================
+    // afterEach runs outside the timed region, e.g. to free what the step built
+    json measure(int repeat, const std::function<void()>& step, const std::function<void()>& afterEach = nullptr) {
+        typedef std::chrono::steady_clock Clock;
+
+        step(); // Warm-up, caches and lazily allocated scratch buffers
+        if (afterEach) afterEach();
+
+        std::vector<double> samples;
+        for (int i = 0; i < repeat; ++i) {
+            const Clock::time_point start = Clock::now();
+            step();
+            samples.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+            if (afterEach) afterEach();
+        }
+
+        std::sort(samples.begin(), samples.end());
+        double mean = 0.0;
+        for (double sample : samples) mean += sample;
+        mean /= samples.size();
+
+        double variance = 0.0;
+        for (double sample : samples) variance += (sample - mean) * (sample - mean);
+        variance /= std::max<size_t>(1, samples.size() - 1);
+
+        const size_t mid = samples.size() / 2;
+        const double median = samples.size() % 2 ? samples[mid] : 0.5 * (samples[mid - 1] + samples[mid]);
+
+        json result;
+        result["median_ms"] = median;
+        result["mean_ms"] = mean;
+        result["stddev_ms"] = std::sqrt(variance);
+        result["min_ms"] = samples.front();
+        result["max_ms"] = samples.back();
+        return result;
+    }
+
+    // Inputs ======================================================================================
+    // A handful of vertices spread over the index range, enough to pin the mesh without over-constraining small ones
+    Eigen::VectorXi chooseHandles(int vertexCount) {
+        const int count = std::max(1, std::min(8, vertexCount / 4));
+        Eigen::VectorXi handles(count);
+        for (int i = 0; i < count; ++i) {
+            handles(i) = static_cast<int>(static_cast<long long>(i) * vertexCount / count);
+        }
+        return handles;
+    }
+
+    std::string makeResponse(int vertexCount) {
+        const int deltas = std::min(vertexCount, kResponseVertices);
+        json frames = json::array();
+        for (int f = 0; f < kResponseFrames; ++f) {
+            json frame;
+            for (int i = 0; i < deltas; ++i) {
+                const double phase = 0.1 * f + 0.01 * i;
+                frame[std::to_string(i)] = {
+                    { "delta_x", 0.01 * std::sin(phase) },
+                    { "delta_y", 0.01 * std::cos(phase) },
+                    { "delta_z", 0.005 * std::sin(2.0 * phase) }
+                };
+            }
+            frames.push_back(frame);
+        }
+        return frames.dump();
+    }
+
+    // Rays from a sphere around the mesh towards its center, Fibonacci spiral so runs are identical
+    void makeRays(const Eigen::MatrixXd& V, std::vector<Eigen::Vector3f>& origins, std::vector<Eigen::Vector3f>& directions) {
+        const Eigen::Vector3d minCorner = V.colwise().minCoeff().transpose();
+        const Eigen::Vector3d maxCorner = V.colwise().maxCoeff().transpose();
+        const Eigen::Vector3f center = (0.5 * (minCorner + maxCorner)).cast<float>();
+        const float radius = static_cast<float>(std::max(1e-6, (maxCorner - minCorner).norm()));
+
+        const float golden = 2.39996323f;
+        for (int i = 0; i < kPickRays; ++i) {
+            const float y = 1.0f - 2.0f * (i + 0.5f) / kPickRays;
+            const float r = std::sqrt(std::max(0.0f, 1.0f - y * y));
+            const Eigen::Vector3f onSphere(r * std::cos(golden * i), y, r * std::sin(golden * i));
+
+            origins.push_back(center + radius * onSphere);
+            directions.push_back(-onSphere);
+        }
+    }
+
+    // ARAP convergence ============================================================================
+    // Energy after every single level iteration from the rest pose, against the coarse to fine solve of the
+    // same edit. Not a timed step, the energy evaluations are left out of the times.
+    json arapConvergence(const Eigen::MatrixXd& V, const Eigen::MatrixXd& targets, igl::ARAPData& data, ArapHierarchy& hierarchy) {
+        typedef std::chrono::steady_clock Clock;
+
+        std::vector<ArapLevelReport> levels;
+        Eigen::MatrixXd deformed;
+        hierarchy.solve(targets, data, kFineIterations, deformed, &levels);
+
+        json hierarchical;
+        json levelList = json::array();
+        double hierarchicalMs = 0.0;
+        for (const ArapLevelReport& level : levels) {
+            levelList.push_back({ { "vertices", level.vertices }, { "iterations", level.iterations },
+                                  { "ms", level.ms }, { "energy", level.energy } });
+            hierarchicalMs += level.ms;
+        }
+        const double hierarchicalEnergy = levels.back().energy;
+        hierarchical["ms"] = hierarchicalMs;
+        hierarchical["energy"] = hierarchicalEnergy;
+        hierarchical["levels"] = levelList;
+
+        const ArapEnergy& energy = hierarchy.getEnergy(0);
+        const int maxIter = data.max_iter;
+        data.max_iter = 1;
+
+        json singleLevel = json::array();
+        Eigen::MatrixXd pose = V;
+        double elapsed = 0.0, matchMs = -1.0;
+        for (int i = 1; i <= kConvergenceIterations; ++i) {
+            const Clock::time_point start = Clock::now();
+            igl::arap_solve(targets, data, pose);
+            elapsed += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+            const double value = energy.evaluate(pose);
+            singleLevel.push_back({ { "iteration", i }, { "ms", elapsed }, { "energy", value } });
+            if (matchMs < 0.0 && value <= hierarchicalEnergy) matchMs = elapsed;
+        }
+        data.max_iter = maxIter;
+
+        json result;
+        result["single_level"] = singleLevel;
+        result["hierarchical"] = hierarchical;
+        if (matchMs >= 0.0) {
+            result["single_level_ms_to_match"] = matchMs;
+            result["speedup"] = matchMs / std::max(1e-9, hierarchicalMs);
+        } else {
+            // Not reached within kConvergenceIterations, the speedup is at least elapsed / hierarchicalMs
+            result["single_level_ms_to_match"] = nullptr;
+            result["speedup"] = nullptr;
+        }
+        return result;
+    }
+
+    // Per mesh ====================================================================================
+    bool benchMesh(const std::string& path, const std::string& name, int repeat, json& result) {
+        std::vector<Eigen::Vector3f> vertices, normals;
+        std::vector<Eigen::Vector3i> indices;
+        if (!MeshLoader::load(path, vertices, normals, indices)) {
+            return false;
+        }
+
+        json steps;
+        std::cerr << "[" << name << "] " << vertices.size() << " vertices, " << indices.size() << " faces" << std::endl;
+
+        steps["load"] = measure(repeat, [&]() {
+            std::vector<Eigen::Vector3f> v, n;
+            std::vector<Eigen::Vector3i> i;
+            MeshLoader::load(path, v, n, i);
+        });
+
+        // The previous mesh is freed outside the timed region
+        std::unique_ptr<MeshData> built, fresh;
+        steps["halfedge_build"] = measure(repeat, [&]() {
+            fresh.reset(new MeshData(vertices, normals, indices));
+        }, [&]() {
+            built = std::move(fresh);
+        });
+        MeshData& mesh = *built;
+
+        steps["geometry_attributes"] = measure(repeat, [&]() {
+            mesh.computeGeometryAttributes();
+        });
+
+        // ARAP
+        const Eigen::MatrixXd& V = mesh.getRestPositions();
+        const Eigen::MatrixXi& F = mesh.getFaces();
+        const Eigen::VectorXi handles = chooseHandles(static_cast<int>(V.rows()));
+
+        std::unique_ptr<igl::ARAPData> arapData;
+        steps["arap_precompute"] = measure(repeat, [&]() {
+            arapData.reset(new igl::ARAPData());
+            arapData->with_dynamics = false;
+            igl::arap_precomputation(V, F, V.cols(), handles, *arapData);
+        });
+
+        Eigen::MatrixXd targets(handles.size(), 3);
+        for (int i = 0; i < handles.size(); ++i) {
+            targets.row(i) = V.row(handles(i));
+        }
+        targets(0, 1) += 0.1 * (V.colwise().maxCoeff() - V.colwise().minCoeff()).norm();
+
+        steps["arap_solve"] = measure(repeat, [&]() {
+            Eigen::MatrixXd deformed = V;
+            igl::arap_solve(targets, *arapData, deformed);
+        });
+
+        std::unique_ptr<ArapHierarchy> hierarchy;
+        steps["arap_hierarchy_build"] = measure(repeat, [&]() {
+            hierarchy.reset(new ArapHierarchy(V, F));
+            hierarchy->setHandles(handles);
+        });
+        steps["arap_hierarchy_build"]["levels"] = hierarchy->getLevelCount();
+
+        steps["arap_hierarchical_solve"] = measure(repeat, [&]() {
+            Eigen::MatrixXd deformed;
+            hierarchy->solve(targets, *arapData, kFineIterations, deformed);
+        });
+        result["arap_convergence"] = arapConvergence(V, targets, *arapData, *hierarchy);
+
+        // Bake, the first handle swings up and down once over the sequence
+        BakeInput bakeInput;
+        bakeInput.restPositions = V;
+        bakeInput.faces = F;
+        bakeInput.basePositions = V;
+        bakeInput.handles = handles;
+        GenAPI::AnimationSequence sequence(kBakeFrames);
+        for (int i = 0; i < kBakeFrames; ++i) {
+            const double offset = targets(0, 1) - V(handles(0), 1);
+            sequence[i][handles(0)] = GenAPI::DeformationDelta(0.0f, static_cast<float>(offset * std::sin(2.0 * M_PI * (i + 1) / kBakeFrames)), 0.0f);
+        }
+        steps["bake"] = measure(repeat, [&]() {
+            AnimationBaker::bake(bakeInput, sequence);
+        });
+        steps["bake"]["frames"] = kBakeFrames;
+
+        bakeInput.dynamics.enabled = true;
+        steps["bake_dynamics"] = measure(repeat, [&]() {
+            AnimationBaker::bake(bakeInput, sequence);
+        });
+        steps["bake_dynamics"]["frames"] = kBakeFrames;
+        steps["bake_dynamics"]["substeps"] = bakeInput.dynamics.substeps;
+
+        // Picking
+        std::vector<Eigen::Vector3f> origins, directions;
+        makeRays(V, origins, directions);
+        int hits = 0;
+        steps["pick"] = measure(repeat, [&]() {
+            hits = 0;
+            for (int i = 0; i < kPickRays; ++i) {
+                float t;
+                if (mesh.pickTriangle(origins[i], directions[i], t) != -1) hits++;
+            }
+        });
+        steps["pick"]["rays"] = kPickRays;
+        steps["pick"]["hits"] = hits;
+
+        // Keyframes at 0..10, like the ones the UI saves
+        for (int idx = 0; idx < static_cast<int>(V.rows()); ++idx) {
+            Vertex& v = mesh.getVertex(idx);
+            for (int t = 0; t <= 10; ++t) {
+                v.timeframePos[static_cast<float>(t)] = v.originalPos + Eigen::Vector3d(0.0, 0.01 * t, 0.0);
+            }
+        }
+        steps["keyframe_interpolation"] = measure(repeat, [&]() {
+            Eigen::Vector3d sum = Eigen::Vector3d::Zero();
+            for (int s = 0; s < kInterpolationSamples; ++s) {
+                const float time = 10.0f * s / kInterpolationSamples;
+                for (int idx = 0; idx < static_cast<int>(V.rows()); ++idx) {
+                    sum += mesh.getVertex(idx).getInterpolatedPos(time);
+                }
+            }
+            if (!std::isfinite(sum.x())) std::cerr << "Non-finite interpolation result" << std::endl;
+        });
+
+        // Response parsing
+        const std::string response = makeResponse(static_cast<int>(V.rows()));
+        steps["response_parse"] = measure(repeat, [&]() {
+            GenAPI::GenerationResponse parsed = GenAPI::DeformationGenerator::parseResponseJson(response);
+            if (!parsed.success) std::cerr << "Synthetic response failed to parse" << std::endl;
+        });
+        steps["response_parse"]["bytes"] = response.size();
+
+        result["name"] = name;
+        result["vertices"] = vertices.size();
+        result["faces"] = indices.size();
+        result["rss_kb"] = MemoryStats::residentBytes() / 1024; // 0 where /proc is missing
+        result["steps"] = steps;
+        return true;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseArgs(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    Logger::setLevel(Logger::Level::Warn); // Loader and solver chatter would end up in every timed pass
+    TaskScheduler::instance().setWorkerCount(options.threads);
+
+    if (options.meshes.empty()) {
+        options.meshes.assign(std::begin(kDefaultMeshes), std::end(kDefaultMeshes));
+    }
+
+    json report;
+    report["version"] = APP_VERSION;
+    report["threads"] = TaskScheduler::instance().getWorkerCount() + 1; // Workers plus the calling thread
+    report["repeat"] = options.repeat;
+
+    json meshes = json::array();
+    int failed = 0;
+    for (const std::string& name : options.meshes) {
+        json result;
+        if (benchMesh(options.assetsDir + "/" + name, name, options.repeat, result)) {
+            meshes.push_back(result);
+        } else {
+            std::cerr << "Skipping " << name << ", failed to load" << std::endl;
+            failed++;
+        }
+    }
+    report["meshes"] = meshes;
+    report["peak_rss_kb"] = peakRssKb();
+
+    if (options.jsonOut.empty()) {
+        std::cout << report.dump(2) << std::endl;
+    } else {
+        std::ofstream out(options.jsonOut);
+        if (!out.is_open()) {
+            std::cerr << "Failed to write " << options.jsonOut << std::endl;
+            return 1;
+        }
+        out << report.dump(2) << std::endl;
+        std::cerr << "Wrote " << options.jsonOut << std::endl;
+    }
+
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,164 @@
+// Load test driver for DeformationGenerator.
+// Fires a fixed number of generation requests from several client threads and reports
+// client-side throughput and latency percentiles. Pair it with the mock server for reproducible runs.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../GenAPI/GenAPI.hpp"
+#include "../GenAPI/json.hpp"
+#include "../Utilities/Logger.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+    struct Options {
+        std::string apiUrl = "http://localhost:8080";
+        int requests = 100;
+        int concurrency = 4;
+        int length = 8;
+        int controlPoints = 8;
+        bool useCache = false;    // Off by default, otherwise only the first request reaches the server
+        bool uniquePrompts = false;
+        std::string jsonOut;
+    };
+
+    void printUsage(const char* program) {
+        std::cout << "Usage: " << program << " [options]\n"
+                  << "  --api <url>              Generation API (default http://localhost:8080)\n"
+                  << "  --requests <n>           Total requests (default 100)\n"
+                  << "  --concurrency <n>        Client threads (default 4)\n"
+                  << "  --length <n>             Frames per request (default 8)\n"
+                  << "  --control-points <n>     Control points per request (default 8)\n"
+                  << "  --cache                  Enable the response cache\n"
+                  << "  --unique-prompts         Use a different prompt per request\n"
+                  << "  --json <file>            Also write the results as JSON\n";
+    }
+
+    bool parseArgs(int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+
+            if (arg == "--api" && hasValue) options.apiUrl = argv[++i];
+            else if (arg == "--requests" && hasValue) options.requests = std::atoi(argv[++i]);
+            else if (arg == "--concurrency" && hasValue) options.concurrency = std::atoi(argv[++i]);
+            else if (arg == "--length" && hasValue) options.length = std::atoi(argv[++i]);
+            else if (arg == "--control-points" && hasValue) options.controlPoints = std::atoi(argv[++i]);
+            else if (arg == "--cache") options.useCache = true;
+            else if (arg == "--unique-prompts") options.uniquePrompts = true;
+            else if (arg == "--json" && hasValue) options.jsonOut = argv[++i];
+            else return false;
+        }
+        return options.requests > 0 && options.concurrency > 0;
+    }
+
+    double percentile(const std::vector<double>& sorted, double p) {
+        if (sorted.empty()) return 0.0;
+        const double rank = p * (sorted.size() - 1);
+        const size_t lower = static_cast<size_t>(rank);
+        const size_t upper = std::min(lower + 1, sorted.size() - 1);
+        return sorted[lower] + (rank - lower) * (sorted[upper] - sorted[lower]);
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseArgs(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    Logger::setLevel(Logger::Level::Warn); // Per-request info lines from the generator would swamp the report
+    GenAPI::DeformationGenerator generator(options.apiUrl);
+    generator.setCacheEnabled(options.useCache);
+
+    if (!generator.isApiAvailable()) {
+        std::cerr << "API at " << options.apiUrl << " is not reachable" << std::endl;
+        return 1;
+    }
+
+    std::vector<GenAPI::ControlPoint> controlPoints;
+    for (int i = 0; i < options.controlPoints; ++i) {
+        controlPoints.emplace_back(i, "unknown", Eigen::Vector3f(0.1f * i, 0.0f, 0.0f));
+    }
+
+    std::atomic<int> nextRequest(0);
+    std::atomic<int> failures(0);
+    std::vector<double> latencies(options.requests, 0.0);
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> clients;
+    for (int c = 0; c < options.concurrency; ++c) {
+        clients.emplace_back([&]() {
+            while (true) {
+                const int index = nextRequest++;
+                if (index >= options.requests) break;
+
+                const std::string prompt = options.uniquePrompts
+                    ? "load test prompt " + std::to_string(index)
+                    : std::string("load test prompt");
+                GenAPI::GenerationRequest request(controlPoints, prompt, options.length);
+
+                auto requestStart = std::chrono::steady_clock::now();
+                GenAPI::GenerationResponse response = generator.generateDeformations(request);
+                latencies[index] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - requestStart).count();
+
+                if (!response.success) failures++;
+            }
+        });
+    }
+
+    for (auto& client : clients) {
+        client.join();
+    }
+
+    const double totalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> sorted = latencies;
+    std::sort(sorted.begin(), sorted.end());
+    double mean = 0.0;
+    for (double l : sorted) mean += l;
+    mean /= sorted.size();
+
+    json result;
+    result["requests"] = options.requests;
+    result["concurrency"] = options.concurrency;
+    result["length"] = options.length;
+    result["control_points"] = options.controlPoints;
+    result["failures"] = failures.load();
+    result["total_seconds"] = totalSeconds;
+    result["throughput_rps"] = options.requests / totalSeconds;
+    result["latency_ms"] = {
+        {"mean", mean},
+        {"p50", percentile(sorted, 0.50)},
+        {"p90", percentile(sorted, 0.90)},
+        {"p99", percentile(sorted, 0.99)},
+        {"max", sorted.back()}
+    };
+
+    std::cout << "Requests:   " << options.requests << " (" << failures << " failed) over "
+              << options.concurrency << " clients" << std::endl;
+    std::cout << "Throughput: " << result["throughput_rps"].get<double>() << " req/s" << std::endl;
+    std::cout << "Latency ms: mean " << mean
+              << "  p50 " << percentile(sorted, 0.50)
+              << "  p90 " << percentile(sorted, 0.90)
+              << "  p99 " << percentile(sorted, 0.99)
+              << "  max " << sorted.back() << std::endl;
+
+    if (!options.jsonOut.empty()) {
+        std::ofstream file(options.jsonOut);
+        file << result.dump(2);
+    }
+
+    return failures == 0 ? 0 : 1;
+}
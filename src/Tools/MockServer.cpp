@@ -0,0 +1,257 @@
+// Local stand-in for the deformation generation service.
+// Implements GET / (health check) and POST /generate-deformations with deterministic synthetic deltas,
+// so GenAPI can be exercised and load tested without the real model.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "../GenAPI/json.hpp"
+
+#ifdef _WIN32
+int main() {
+    std::cerr << "The mock server only supports POSIX sockets" << std::endl;
+    return 1;
+}
+#else
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using json = nlohmann::json;
+
+namespace {
+    struct Options {
+        int port = 8080;
+        int latencyMs = 0;      // Fixed delay before every response
+        int jitterMs = 0;       // Extra uniformly distributed delay
+        int extraVertices = 0;  // Additional deltas per frame to inflate the payload
+        double errorRate = 0.0; // Fraction of requests answered with an error
+        unsigned int seed = 1;
+    };
+
+    std::atomic<uint64_t> s_requestCount(0);
+
+    void printUsage(const char* program) {
+        std::cout << "Usage: " << program << " [options]\n"
+                  << "  --port <n>            Listen port (default 8080)\n"
+                  << "  --latency-ms <n>      Delay before each response (default 0)\n"
+                  << "  --jitter-ms <n>       Additional random delay (default 0)\n"
+                  << "  --extra-vertices <n>  Extra vertex deltas per frame (default 0)\n"
+                  << "  --error-rate <f>      Fraction of failed requests, 0..1 (default 0)\n"
+                  << "  --seed <n>            Seed for jitter and error injection (default 1)\n";
+    }
+
+    bool parseArgs(int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+
+            if (arg == "--port" && hasValue) options.port = std::atoi(argv[++i]);
+            else if (arg == "--latency-ms" && hasValue) options.latencyMs = std::atoi(argv[++i]);
+            else if (arg == "--jitter-ms" && hasValue) options.jitterMs = std::atoi(argv[++i]);
+            else if (arg == "--extra-vertices" && hasValue) options.extraVertices = std::atoi(argv[++i]);
+            else if (arg == "--error-rate" && hasValue) options.errorRate = std::atof(argv[++i]);
+            else if (arg == "--seed" && hasValue) options.seed = static_cast<unsigned int>(std::atoi(argv[++i]));
+            else return false;
+        }
+        return true;
+    }
+
+    uint64_t hashString(const std::string& str) {
+        uint64_t h = 14695981039346656037ULL;
+        for (unsigned char c : str) {
+            h ^= c;
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
+
+    // Same request always produces the same animation: a per-vertex sinusoid seeded by prompt and id
+    json generateFrames(const json& request, const Options& options) {
+        const std::string prompt = request.value("prompt", std::string());
+        const int length = std::max(1, request.value("length", 1));
+        const uint64_t promptHash = hashString(prompt);
+
+        std::vector<int> ids;
+        for (const auto& cp : request["control_points"]) {
+            ids.push_back(cp["id"].get<int>());
+        }
+        for (int i = 0; i < options.extraVertices; ++i) {
+            ids.push_back(1000000 + i); // Out of range ids, the client ignores them
+        }
+
+        json frames = json::array();
+        for (int f = 0; f < length; ++f) {
+            const double t = length == 1 ? 1.0 : static_cast<double>(f + 1) / length;
+            json frame = json::object();
+            for (int id : ids) {
+                const uint64_t h = promptHash ^ (static_cast<uint64_t>(id) * 0x9E3779B97F4A7C15ULL);
+                const double phase = static_cast<double>(h % 6283) / 1000.0;
+                const double amplitude = 0.02 + static_cast<double>((h >> 16) % 100) / 1000.0;
+                frame[std::to_string(id)] = {
+                    {"delta_x", amplitude * std::sin(2.0 * M_PI * t + phase)},
+                    {"delta_y", amplitude * std::cos(2.0 * M_PI * t + phase)},
+                    {"delta_z", 0.5 * amplitude * std::sin(4.0 * M_PI * t + phase)}
+                };
+            }
+            frames.push_back(frame);
+        }
+        return frames;
+    }
+
+    bool readRequest(int client, std::string& method, std::string& path, std::string& body) {
+        std::string data;
+        char buffer[8192];
+        size_t headerEnd = std::string::npos;
+
+        while (headerEnd == std::string::npos) {
+            ssize_t n = recv(client, buffer, sizeof(buffer), 0);
+            if (n <= 0) return false;
+            data.append(buffer, n);
+            headerEnd = data.find("\r\n\r\n");
+        }
+
+        std::istringstream requestLine(data.substr(0, data.find("\r\n")));
+        requestLine >> method >> path;
+
+        size_t contentLength = 0;
+        std::string headers = data.substr(0, headerEnd);
+        std::transform(headers.begin(), headers.end(), headers.begin(), ::tolower);
+        size_t pos = headers.find("content-length:");
+        if (pos != std::string::npos) {
+            contentLength = std::strtoul(headers.c_str() + pos + 15, nullptr, 10);
+        }
+
+        body = data.substr(headerEnd + 4);
+        while (body.size() < contentLength) {
+            ssize_t n = recv(client, buffer, sizeof(buffer), 0);
+            if (n <= 0) return false;
+            body.append(buffer, n);
+        }
+        return true;
+    }
+
+    void sendResponse(int client, int status, const std::string& body) {
+        const char* reason = status == 200 ? "OK" : (status == 404 ? "Not Found" : (status == 400 ? "Bad Request" : "Internal Server Error"));
+        std::ostringstream response;
+        response << "HTTP/1.1 " << status << " " << reason << "\r\n"
+                 << "Content-Type: application/json\r\n"
+                 << "Content-Length: " << body.size() << "\r\n"
+                 << "Connection: close\r\n\r\n"
+                 << body;
+
+        const std::string out = response.str();
+        size_t sent = 0;
+        while (sent < out.size()) {
+            ssize_t n = send(client, out.data() + sent, out.size() - sent, 0);
+            if (n <= 0) break;
+            sent += n;
+        }
+    }
+
+    void handleClient(int client, const Options& options) {
+        std::string method, path, body;
+        if (!readRequest(client, method, path, body)) {
+            close(client);
+            return;
+        }
+
+        const uint64_t requestIndex = s_requestCount++;
+
+        if (method == "GET") {
+            sendResponse(client, 200, "{\"status\": \"ok\"}");
+            close(client);
+            return;
+        }
+
+        if (method != "POST" || path != "/generate-deformations") {
+            sendResponse(client, 404, "{\"error\": \"Unknown endpoint\"}");
+            close(client);
+            return;
+        }
+
+        // Jitter and error injection are keyed on the request index, so a rerun with the same seed repeats them
+        std::mt19937 rng(options.seed + static_cast<unsigned int>(requestIndex));
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+        int delayMs = options.latencyMs + static_cast<int>(uniform(rng) * options.jitterMs);
+        if (delayMs > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+        }
+
+        if (uniform(rng) < options.errorRate) {
+            sendResponse(client, 500, "{\"error\": \"Injected failure\"}");
+            close(client);
+            return;
+        }
+
+        try {
+            json request = json::parse(body);
+            sendResponse(client, 200, generateFrames(request, options).dump());
+        } catch (const std::exception& e) {
+            json error;
+            error["error"] = std::string("Bad request: ") + e.what();
+            sendResponse(client, 400, error.dump());
+        }
+        close(client);
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseArgs(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+
+    int server = socket(AF_INET, SOCK_STREAM, 0);
+    if (server < 0) {
+        std::cerr << "Failed to create socket" << std::endl;
+        return 1;
+    }
+
+    int reuse = 1;
+    setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<uint16_t>(options.port));
+
+    if (bind(server, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(server, 128) < 0) {
+        std::cerr << "Failed to listen on port " << options.port << std::endl;
+        close(server);
+        return 1;
+    }
+
+    std::cout << "Mock deformation server on http://localhost:" << options.port
+              << " (latency " << options.latencyMs << "+" << options.jitterMs << "ms, "
+              << options.extraVertices << " extra vertices, error rate " << options.errorRate << ")" << std::endl;
+
+    while (true) {
+        int client = accept(server, nullptr, nullptr);
+        if (client < 0) continue;
+        std::thread(handleClient, client, std::cref(options)).detach();
+    }
+
+    close(server);
+    return 0;
+}
+
+#endif
@@ -37,6 +37,13 @@ void Trackball::rotate(float deltaPhi, float deltaTheta) {
     updateCameraPosition();
 }
 
+void Trackball::setOrbit(float phi, float theta, float radius) {
+    m_phi = phi;
+    m_theta = std::min(std::max(theta, 0.01f), float(M_PI - 0.01f));
+    m_radius = std::max(radius, 0.1f);
+    updateCameraPosition();
+}
+
 void Trackball::zoom(float delta) {
     m_radius += delta;
     m_radius = std::max(m_radius, 0.1f);
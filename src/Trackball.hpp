@@ -45,6 +45,7 @@ public:
     void resize(int width, int height);
 
     void rotate(float deltaPhi, float deltaTheta);
+    void setOrbit(float phi, float theta, float radius); // Absolute, for scripted camera paths
     void zoom(float delta);
     void pan(double x, double y);
 
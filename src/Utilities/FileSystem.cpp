@@ -0,0 +1,34 @@
+#include "FileSystem.hpp"
+
+#include <cerrno>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace FileSystem {
+
+bool makeDirectory(const std::string& dir) {
+    if (dir.empty()) return true;
+
+    // Only the full path has to succeed, failures on parents (existing ones, drive roots) are ignored
+    size_t pos = 0;
+    do {
+        pos = dir.find_first_of("/\\", pos + 1);
+        const std::string prefix = dir.substr(0, pos);
+#ifdef _WIN32
+        if (!CreateDirectoryA(prefix.c_str(), NULL) && GetLastError() != ERROR_ALREADY_EXISTS && pos == std::string::npos) {
+            return false;
+        }
+#else
+        if (mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST && pos == std::string::npos) {
+            return false;
+        }
+#endif
+    } while (pos != std::string::npos);
+    return true;
+}
+
+} // namespace FileSystem
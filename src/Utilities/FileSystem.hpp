@@ -0,0 +1,14 @@
+#ifndef FILE_SYSTEM_HPP
+#define FILE_SYSTEM_HPP
+
+#include <string>
+
+// Small filesystem helpers on top of the OS calls, paths never go through a shell
+namespace FileSystem {
+
+    // Creates dir and any missing parents, like mkdir -p. True if dir exists afterwards.
+    bool makeDirectory(const std::string& dir);
+
+}
+
+#endif // FILE_SYSTEM_HPP
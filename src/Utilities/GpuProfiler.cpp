@@ -0,0 +1,68 @@
+#include "GpuProfiler.hpp"
+
+#include <map>
+#include <string>
+
+namespace Profiler {
+
+namespace {
+    const int kQueriesPerScope = 4; // Frames a result may stay in flight before the scope skips a sample
+
+    struct QueryRing {
+        GLuint queries[kQueriesPerScope];
+        bool pending[kQueriesPerScope];
+        int next = 0;
+    };
+
+    // Render thread only
+    std::map<std::string, QueryRing> s_rings;
+    bool s_queryOpen = false;
+}
+
+GpuScope::GpuScope(const char* name) : m_active(false) {
+    if (!isEnabled() || s_queryOpen) return;
+
+    auto it = s_rings.find(name);
+    if (it == s_rings.end()) {
+        QueryRing ring;
+        glGenQueries(kQueriesPerScope, ring.queries);
+        for (int i = 0; i < kQueriesPerScope; ++i) ring.pending[i] = false;
+        it = s_rings.emplace(name, ring).first;
+    }
+
+    QueryRing& ring = it->second;
+    if (ring.pending[ring.next]) return; // GPU is more than kQueriesPerScope frames behind
+
+    glBeginQuery(GL_TIME_ELAPSED, ring.queries[ring.next]);
+    ring.pending[ring.next] = true;
+    ring.next = (ring.next + 1) % kQueriesPerScope;
+
+    s_queryOpen = true;
+    m_active = true;
+}
+
+GpuScope::~GpuScope() {
+    if (!m_active) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    s_queryOpen = false;
+}
+
+void collectGpuTimings() {
+    for (auto& entry : s_rings) {
+        QueryRing& ring = entry.second;
+        for (int i = 0; i < kQueriesPerScope; ++i) {
+            if (!ring.pending[i]) continue;
+
+            GLint available = 0;
+            glGetQueryObjectiv(ring.queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) continue;
+
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(ring.queries[i], GL_QUERY_RESULT, &elapsed);
+            ring.pending[i] = false;
+            recordSample(entry.first.c_str(), Source::Gpu, elapsed / 1.0e6);
+        }
+    }
+}
+
+} // namespace Profiler
@@ -0,0 +1,36 @@
+#ifndef GPU_PROFILER_HPP
+#define GPU_PROFILER_HPP
+
+#include <glad/glad.h>
+
+#include "Profiler.hpp"
+
+// GL_TIME_ELAPSED queries around draws and uploads, render thread only.
+// Results are read a few frames later when they are available, so the CPU never waits on the GPU.
+// Elapsed-time queries cannot nest: a scope opened inside another one is skipped.
+namespace Profiler {
+
+    class GpuScope {
+    private:
+        bool m_active;
+
+    public:
+        explicit GpuScope(const char* name);
+        ~GpuScope();
+
+        GpuScope(const GpuScope&) = delete;
+        GpuScope& operator=(const GpuScope&) = delete;
+    };
+
+    // Once per frame, moves finished query results into the profiler
+    void collectGpuTimings();
+
+} // namespace Profiler
+
+#ifdef AUCAD_NO_PROFILER
+#define PROFILE_GPU_SCOPE(name) do {} while (0)
+#else
+#define PROFILE_GPU_SCOPE(name) Profiler::GpuScope PROFILER_CONCAT(profileGpuScope_, __LINE__)(name)
+#endif
+
+#endif // GPU_PROFILER_HPP
@@ -0,0 +1,161 @@
+#include "Logger.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Logger {
+
+namespace {
+    const size_t kQueueCapacity = 8192;
+
+    struct Entry {
+        Level level = Level::Info;
+        double seconds = 0.0; // Since startup
+        std::string message;
+    };
+
+    std::atomic<int> s_level(static_cast<int>(Level::Info));
+    const std::chrono::steady_clock::time_point s_start = std::chrono::steady_clock::now();
+
+    std::mutex s_mutex;
+    std::condition_variable s_wake;     // Writer: entries queued or stopping
+    std::condition_variable s_written;  // flush() and full-queue errors: a batch went out
+    std::vector<Entry> s_ring;
+    size_t s_head = 0, s_count = 0;
+    size_t s_dropped = 0;
+    uint64_t s_queuedSeq = 0, s_writtenSeq = 0;
+    bool s_running = false, s_stopping = false;
+    std::thread s_writer;
+
+    const char* levelName(Level level) {
+        switch (level) {
+            case Level::Trace: return "trace";
+            case Level::Debug: return "debug";
+            case Level::Info:  return "info";
+            case Level::Warn:  return "warn";
+            case Level::Error: return "error";
+            default:           return "";
+        }
+    }
+
+    void print(const Entry& entry) {
+        FILE* out = entry.level >= Level::Warn ? stderr : stdout;
+        fprintf(out, "[%9.3f] [%s] %s\n", entry.seconds, levelName(entry.level), entry.message.c_str());
+    }
+
+    void writerLoop() {
+        std::vector<Entry> batch;
+        std::unique_lock<std::mutex> lock(s_mutex);
+        while (true) {
+            s_wake.wait(lock, []() { return s_count > 0 || s_stopping; });
+            if (s_count == 0) break; // Stopping and drained
+
+            batch.clear();
+            while (s_count > 0) {
+                batch.push_back(std::move(s_ring[s_head]));
+                s_head = (s_head + 1) % kQueueCapacity;
+                s_count--;
+            }
+            const size_t dropped = s_dropped;
+            s_dropped = 0;
+            const uint64_t batchEnd = s_queuedSeq;
+            lock.unlock();
+
+            for (const Entry& entry : batch) print(entry);
+            if (dropped > 0) {
+                fprintf(stderr, "[%9.3f] [warn] %zu log messages dropped, the queue was full\n",
+                        std::chrono::duration<double>(std::chrono::steady_clock::now() - s_start).count(), dropped);
+            }
+            fflush(stdout);
+            fflush(stderr);
+
+            lock.lock();
+            s_writtenSeq = batchEnd;
+            s_written.notify_all();
+        }
+    }
+}
+
+void setLevel(Level level) {
+    s_level.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+Level getLevel() {
+    return static_cast<Level>(s_level.load(std::memory_order_relaxed));
+}
+
+bool parseLevel(const std::string& name, Level& level) {
+    for (int i = 0; i <= static_cast<int>(Level::Off); ++i) {
+        const Level candidate = static_cast<Level>(i);
+        if (name == (candidate == Level::Off ? "off" : levelName(candidate))) {
+            level = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+void write(Level level, std::string message) {
+    Entry entry;
+    entry.level = level;
+    entry.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - s_start).count();
+    entry.message = std::move(message);
+
+    std::unique_lock<std::mutex> lock(s_mutex);
+    if (s_stopping) {
+        // After shutdown (static destructors, atexit handlers) there is no writer left
+        print(entry);
+        fflush(entry.level >= Level::Warn ? stderr : stdout);
+        return;
+    }
+    if (!s_running) {
+        s_ring.resize(kQueueCapacity);
+        s_writer = std::thread(writerLoop);
+        s_running = true;
+        std::atexit(shutdown); // Runs before s_writer is destroyed, it was constructed earlier
+    }
+
+    if (s_count == kQueueCapacity) {
+        if (level < Level::Error) {
+            s_dropped++;
+            return;
+        }
+        s_written.wait(lock, []() { return s_count < kQueueCapacity || s_stopping; }); // Errors are never dropped
+        if (s_stopping) {
+            print(entry);
+            return;
+        }
+    }
+
+    s_ring[(s_head + s_count) % kQueueCapacity] = std::move(entry);
+    s_count++;
+    s_queuedSeq++;
+    lock.unlock();
+    s_wake.notify_one();
+}
+
+void flush() {
+    std::unique_lock<std::mutex> lock(s_mutex);
+    if (!s_running || s_stopping) return;
+    const uint64_t target = s_queuedSeq;
+    s_written.wait(lock, [target]() { return s_writtenSeq >= target; });
+}
+
+void shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        if (!s_running || s_stopping) return;
+        s_stopping = true;
+    }
+    s_wake.notify_one();
+    s_written.notify_all();
+    s_writer.join();
+}
+
+} // namespace Logger
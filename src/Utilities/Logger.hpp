@@ -0,0 +1,75 @@
+#ifndef LOGGER_HPP
+#define LOGGER_HPP
+
+#include <sstream>
+#include <string>
+
+// Leveled logging with a background writer. LOG_* formats the message on the calling thread and
+// hands it to a bounded queue, the writer thread prints batches and flushes once per batch.
+// When the queue is full messages are dropped (and counted) rather than stalling a solver or the
+// render loop. Warnings and errors go to stderr, everything else to stdout.
+//
+// Levels below AUCAD_LOG_MIN_LEVEL are compiled out, by default debug and trace in release builds.
+// The runtime level (default info) filters the rest for one relaxed load per statement.
+namespace Logger {
+
+    enum class Level {
+        Trace = 0,
+        Debug = 1,
+        Info  = 2,
+        Warn  = 3,
+        Error = 4,
+        Off   = 5
+    };
+
+    void setLevel(Level level);
+    Level getLevel();
+    bool parseLevel(const std::string& name, Level& level); // trace, debug, info, warn, error, off
+
+    inline bool isEnabled(Level level) { return level >= getLevel(); }
+
+    void write(Level level, std::string message);
+    void flush();       // Blocks until everything queued so far is written, call before std::terminate
+    void shutdown();    // Drains and stops the writer, later messages are written synchronously
+
+} // namespace Logger
+
+#define AUCAD_LOG_LEVEL_TRACE 0
+#define AUCAD_LOG_LEVEL_DEBUG 1
+#define AUCAD_LOG_LEVEL_INFO  2
+
+#ifndef AUCAD_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define AUCAD_LOG_MIN_LEVEL AUCAD_LOG_LEVEL_INFO
+#else
+#define AUCAD_LOG_MIN_LEVEL AUCAD_LOG_LEVEL_TRACE
+#endif
+#endif
+
+// LOG_INFO("Loaded " << count << " frames"), the stream expression is only evaluated when enabled
+#define LOG_AT(level, expr) \
+    do { \
+        if (Logger::isEnabled(level)) { \
+            std::ostringstream logStream_; \
+            logStream_ << expr; \
+            Logger::write(level, logStream_.str()); \
+        } \
+    } while (0)
+
+#if AUCAD_LOG_MIN_LEVEL <= AUCAD_LOG_LEVEL_TRACE
+#define LOG_TRACE(expr) LOG_AT(Logger::Level::Trace, expr)
+#else
+#define LOG_TRACE(expr) do {} while (0)
+#endif
+
+#if AUCAD_LOG_MIN_LEVEL <= AUCAD_LOG_LEVEL_DEBUG
+#define LOG_DEBUG(expr) LOG_AT(Logger::Level::Debug, expr)
+#else
+#define LOG_DEBUG(expr) do {} while (0)
+#endif
+
+#define LOG_INFO(expr) LOG_AT(Logger::Level::Info, expr)
+#define LOG_WARN(expr) LOG_AT(Logger::Level::Warn, expr)
+#define LOG_ERROR(expr) LOG_AT(Logger::Level::Error, expr)
+
+#endif // LOGGER_HPP
@@ -0,0 +1,95 @@
+#include "MemoryStats.hpp"
+#include "Logger.hpp"
+#include "../GenAPI/json.hpp"
+
+#include <cstdio>
+#include <fstream>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+namespace MemoryStats {
+
+void add(Report& report, const std::string& category, const std::string& name, size_t count, size_t bytes) {
+    Entry entry;
+    entry.category = category;
+    entry.name = name;
+    entry.count = count;
+    entry.bytes = bytes;
+    report.push_back(entry);
+}
+
+size_t total(const Report& report) {
+    size_t sum = 0;
+    for (const Entry& entry : report) sum += entry.bytes;
+    return sum;
+}
+
+size_t totalFor(const Report& report, const std::string& category) {
+    size_t sum = 0;
+    for (const Entry& entry : report) {
+        if (entry.category == category) sum += entry.bytes;
+    }
+    return sum;
+}
+
+size_t residentBytes() {
+#if defined(__linux__)
+    long pages = 0, resident = 0;
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (!statm) return 0;
+    if (fscanf(statm, "%ld %ld", &pages, &resident) != 2) resident = 0;
+    fclose(statm);
+    return static_cast<size_t>(resident) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+    return 0;
+#endif
+}
+
+std::string format(size_t bytes) {
+    const char* units[] = { "B", "KB", "MB", "GB" };
+    double value = static_cast<double>(bytes);
+    int unit = 0;
+    while (value >= 1024.0 && unit < 3) {
+        value /= 1024.0;
+        unit++;
+    }
+
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), unit == 0 ? "%.0f %s" : "%.1f %s", value, units[unit]);
+    return buffer;
+}
+
+bool writeReport(const Report& report, const std::string& path) {
+    nlohmann::json entries = nlohmann::json::array();
+    nlohmann::json categories = nlohmann::json::object();
+    for (const Entry& entry : report) {
+        nlohmann::json item;
+        item["category"] = entry.category;
+        item["name"] = entry.name;
+        item["count"] = entry.count;
+        item["bytes"] = entry.bytes;
+        entries.push_back(item);
+
+        if (!categories.contains(entry.category)) categories[entry.category] = 0;
+        categories[entry.category] = categories[entry.category].get<size_t>() + entry.bytes;
+    }
+
+    nlohmann::json root;
+    root["total_bytes"] = total(report);
+    root["resident_bytes"] = residentBytes();
+    root["categories"] = categories;
+    root["entries"] = entries;
+
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        LOG_ERROR("Failed to write memory report: " << path);
+        return false;
+    }
+    out << root.dump(2) << std::endl;
+    LOG_INFO("Wrote memory report to " << path);
+    return true;
+}
+
+} // namespace MemoryStats
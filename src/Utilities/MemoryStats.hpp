@@ -0,0 +1,54 @@
+#ifndef MEMORY_STATS_HPP
+#define MEMORY_STATS_HPP
+
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+// Byte counts of the big containers, collected on demand by whoever owns them. Sizes are what the
+// containers hold (capacity for vectors, an estimated node size for maps), allocator overhead and
+// fragmentation are not included, compare the total with the resident size for those.
+namespace MemoryStats {
+
+    struct Entry {
+        std::string category;   // Mesh, Keyframes, Animation, Solver, GPU
+        std::string name;
+        size_t count;           // Elements, keyframes, nonzeros, ... whatever the name says
+        size_t bytes;
+    };
+
+    typedef std::vector<Entry> Report;
+
+    // Red-black tree node: three pointers and the color next to the value
+    const size_t kMapNodeOverhead = 4 * sizeof(void*);
+
+    template <typename T>
+    size_t bytes(const std::vector<T>& v) { return v.capacity() * sizeof(T); }
+
+    inline size_t bytes(const std::vector<bool>& v) { return (v.capacity() + 7) / 8; }
+
+    template <typename K, typename V>
+    size_t bytes(const std::map<K, V>& m) { return m.size() * (sizeof(typename std::map<K, V>::value_type) + kMapNodeOverhead); }
+
+    template <typename Derived>
+    size_t bytes(const Eigen::PlainObjectBase<Derived>& m) { return m.size() * sizeof(typename Derived::Scalar); }
+
+    template <typename Scalar, int Options, typename StorageIndex>
+    size_t bytes(const Eigen::SparseMatrix<Scalar, Options, StorageIndex>& m) {
+        return m.nonZeros() * (sizeof(Scalar) + sizeof(StorageIndex)) + (m.outerSize() + 1) * sizeof(StorageIndex);
+    }
+
+    void add(Report& report, const std::string& category, const std::string& name, size_t count, size_t bytes);
+    size_t total(const Report& report);
+    size_t totalFor(const Report& report, const std::string& category);
+
+    size_t residentBytes();     // Whole process, 0 where /proc is not available
+    std::string format(size_t bytes); // "12.3 MB"
+    bool writeReport(const Report& report, const std::string& path); // JSON
+
+} // namespace MemoryStats
+
+#endif // MEMORY_STATS_HPP
@@ -0,0 +1,31 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include "TaskScheduler.hpp"
+
+// Thin loop helpers over the shared TaskScheduler
+namespace Parallel {
+
+    // Threads that take part in a loop, the pool plus the caller
+    inline int workerCount() {
+        return TaskScheduler::instance().getWorkerCount() + 1;
+    }
+
+    // Splits [begin, end) into chunks of at least minChunk items and calls fn(chunkBegin, chunkEnd).
+    // The calling thread runs chunks too, small ranges run inline. Named loops show up in the task stats.
+    template <typename Func>
+    void forChunks(int begin, int end, Func fn, int minChunk = 1, const char* name = nullptr) {
+        TaskScheduler::instance().parallelFor(begin, end, fn, minChunk, name);
+    }
+
+    // Calls fn(i) for every i in [begin, end)
+    template <typename Func>
+    void forEach(int begin, int end, Func fn, int minChunk = 1, const char* name = nullptr) {
+        forChunks(begin, end, [&fn](int chunkBegin, int chunkEnd) {
+            for (int i = chunkBegin; i < chunkEnd; ++i) fn(i);
+        }, minChunk, name);
+    }
+
+} // namespace Parallel
+
+#endif // PARALLEL_HPP
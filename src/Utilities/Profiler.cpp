@@ -0,0 +1,217 @@
+#include "Profiler.hpp"
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace Profiler {
+
+std::atomic<int> g_mode(0);
+
+namespace {
+    const size_t kWindow = 240; // A few seconds of frames
+
+    struct ScopeData {
+        std::vector<double> samples; // Ring buffer of the last kWindow samples
+        size_t next = 0;
+    };
+
+    std::mutex s_mutex;
+    std::map<std::pair<std::string, Source>, ScopeData> s_scopes;
+
+    // Trace
+    const uint64_t kTraceCapacity = 1 << 14; // Events per thread
+
+    // Fields are atomics so a dump racing the owning thread reads stale values instead of undefined ones
+    struct TraceEvent {
+        std::atomic<const char*> name{nullptr};
+        std::atomic<int64_t> startUs{0};
+        std::atomic<int64_t> durationUs{0};
+    };
+
+    struct ThreadTrace {
+        int id = 0;
+        std::string name;                     // Guarded by s_traceMutex
+        std::unique_ptr<TraceEvent[]> events;
+        std::atomic<uint64_t> head{0};        // Total events written, only the owning thread stores
+    };
+
+    // Rings are never freed, events of threads that already exited can still be written out
+    std::mutex s_traceMutex;
+    std::vector<std::unique_ptr<ThreadTrace>> s_threadTraces;
+    std::atomic<int64_t> s_traceStartUs(0);
+
+    thread_local ThreadTrace* t_trace = nullptr;
+    thread_local std::string t_threadName;
+
+    int64_t toMicroseconds(std::chrono::steady_clock::time_point time) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+    }
+
+    ThreadTrace* threadTrace() {
+        if (!t_trace) {
+            std::unique_ptr<ThreadTrace> trace(new ThreadTrace());
+            trace->events.reset(new TraceEvent[kTraceCapacity]);
+
+            std::lock_guard<std::mutex> lock(s_traceMutex);
+            trace->id = static_cast<int>(s_threadTraces.size()) + 1;
+            trace->name = t_threadName.empty() ? "thread " + std::to_string(trace->id) : t_threadName;
+            t_trace = trace.get();
+            s_threadTraces.push_back(std::move(trace));
+        }
+        return t_trace;
+    }
+
+    void setMode(int mode, bool on) {
+        if (on) g_mode.fetch_or(mode, std::memory_order_relaxed);
+        else g_mode.fetch_and(~mode, std::memory_order_relaxed);
+    }
+
+    void writeEscaped(std::ostream& out, const std::string& text) {
+        for (char c : text) {
+            if (c == '"' || c == '\\') out << '\\' << c;
+            else if (static_cast<unsigned char>(c) < 0x20) out << ' ';
+            else out << c;
+        }
+    }
+}
+
+void setEnabled(bool enabled) {
+    setMode(ModeOverlay, enabled);
+}
+
+void recordSample(const char* name, Source source, double ms) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    ScopeData& scope = s_scopes[std::make_pair(std::string(name), source)];
+    if (scope.samples.size() < kWindow) {
+        scope.samples.push_back(ms);
+    } else {
+        scope.samples[scope.next] = ms;
+    }
+    scope.next = (scope.next + 1) % kWindow;
+}
+
+std::vector<ScopeSummary> getSummaries() {
+    std::vector<ScopeSummary> summaries;
+    std::lock_guard<std::mutex> lock(s_mutex);
+
+    for (const auto& entry : s_scopes) {
+        std::vector<double> sorted = entry.second.samples;
+        if (sorted.empty()) continue;
+        std::sort(sorted.begin(), sorted.end());
+
+        double total = 0.0;
+        for (double sample : sorted) total += sample;
+
+        ScopeSummary summary;
+        summary.name = entry.first.first;
+        summary.source = entry.first.second;
+        summary.samples = static_cast<int>(sorted.size());
+        summary.meanMs = total / sorted.size();
+        summary.p95Ms = sorted[std::min(sorted.size() - 1, static_cast<size_t>(0.95 * sorted.size()))];
+        summary.maxMs = sorted.back();
+        summaries.push_back(summary);
+    }
+    return summaries;
+}
+
+void reset() {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_scopes.clear();
+}
+
+// Trace ==============================================================================================
+void startTrace() {
+    s_traceStartUs = toMicroseconds(std::chrono::steady_clock::now());
+    setMode(ModeTrace, true);
+}
+
+void stopTrace() {
+    setMode(ModeTrace, false);
+}
+
+void setThreadName(const std::string& name) {
+    t_threadName = name;
+    if (t_trace) {
+        std::lock_guard<std::mutex> lock(s_traceMutex);
+        t_trace->name = name;
+    }
+}
+
+void recordTraceEvent(const char* name, std::chrono::steady_clock::time_point start,
+                      std::chrono::steady_clock::time_point end) {
+    ThreadTrace* trace = threadTrace();
+    const uint64_t index = trace->head.load(std::memory_order_relaxed);
+
+    TraceEvent& event = trace->events[index % kTraceCapacity];
+    event.name.store(name, std::memory_order_relaxed);
+    event.startUs.store(toMicroseconds(start), std::memory_order_relaxed);
+    event.durationUs.store(toMicroseconds(end) - toMicroseconds(start), std::memory_order_relaxed);
+
+    trace->head.store(index + 1, std::memory_order_release);
+}
+
+bool writeChromeTrace(const std::string& path) {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        LOG_ERROR("Failed to write trace file: " << path);
+        return false;
+    }
+
+    const int64_t sessionStart = s_traceStartUs;
+    size_t eventCount = 0;
+    bool first = true;
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    std::lock_guard<std::mutex> lock(s_traceMutex);
+    for (const auto& trace : s_threadTraces) {
+        file << (first ? "\n" : ",\n");
+        first = false;
+        file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << trace->id << ",\"args\":{\"name\":\"";
+        writeEscaped(file, trace->name);
+        file << "\"}}";
+
+        // The owner may already be rewriting the slot after headAfter, anything it could have touched
+        // while we copied is dropped
+        const uint64_t head = trace->head.load(std::memory_order_acquire);
+        const uint64_t begin = head > kTraceCapacity ? head - kTraceCapacity : 0;
+
+        struct Copy {
+            uint64_t index;
+            const char* name;
+            int64_t startUs;
+            int64_t durationUs;
+        };
+        std::vector<Copy> copies;
+        copies.reserve(head - begin);
+        for (uint64_t i = begin; i < head; ++i) {
+            const TraceEvent& event = trace->events[i % kTraceCapacity];
+            copies.push_back({ i, event.name.load(std::memory_order_relaxed),
+                               event.startUs.load(std::memory_order_relaxed),
+                               event.durationUs.load(std::memory_order_relaxed) });
+        }
+        const uint64_t headAfter = trace->head.load(std::memory_order_acquire);
+        const uint64_t valid = headAfter + 1 > kTraceCapacity ? headAfter + 1 - kTraceCapacity : 0;
+
+        for (const Copy& copy : copies) {
+            if (copy.index < valid || !copy.name || copy.startUs < sessionStart) continue;
+
+            file << ",\n{\"name\":\"";
+            writeEscaped(file, copy.name);
+            file << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << trace->id
+                 << ",\"ts\":" << (copy.startUs - sessionStart) << ",\"dur\":" << copy.durationUs << "}";
+            eventCount++;
+        }
+    }
+
+    file << "\n]}\n";
+    LOG_INFO("Wrote " << eventCount << " trace events to " << path);
+    return true;
+}
+
+} // namespace Profiler
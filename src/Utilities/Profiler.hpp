@@ -0,0 +1,92 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Scoped CPU timers aggregated per name into a rolling window (the overlay) and/or recorded into
+// per-thread ring buffers that can be written out as a Chrome trace (chrome://tracing, ui.perfetto.dev).
+// Disabled (the default) a scope costs one relaxed atomic load, build with AUCAD_NO_PROFILER to strip them.
+// GL timer queries live in GpuProfiler.hpp so this stays usable without a GL context.
+// Scope names are kept by pointer in the trace, pass string literals.
+namespace Profiler {
+
+    enum Mode {
+        ModeOverlay = 1 << 0,
+        ModeTrace   = 1 << 1
+    };
+
+    extern std::atomic<int> g_mode;
+
+    inline int activeModes() { return g_mode.load(std::memory_order_relaxed); }
+    inline bool isEnabled() { return (activeModes() & ModeOverlay) != 0; }
+    inline bool isTracing() { return (activeModes() & ModeTrace) != 0; }
+    void setEnabled(bool enabled);
+
+    enum class Source {
+        Cpu,
+        Gpu
+    };
+
+    void recordSample(const char* name, Source source, double ms);
+
+    struct ScopeSummary {
+        std::string name;
+        Source source;
+        int samples;    // In the rolling window
+        double meanMs;
+        double p95Ms;
+        double maxMs;
+    };
+
+    std::vector<ScopeSummary> getSummaries(); // Sorted by name
+    void reset();
+
+    // Trace ==========================================================================================
+    // Every thread writes its own ring without locking, the oldest events are overwritten once it is full.
+    void startTrace();
+    void stopTrace();
+    bool writeChromeTrace(const std::string& path); // Events since the last startTrace, may be called while tracing
+    void setThreadName(const std::string& name);     // Shown as the track name in the trace viewer
+    void recordTraceEvent(const char* name, std::chrono::steady_clock::time_point start,
+                          std::chrono::steady_clock::time_point end);
+
+    class CpuScope {
+    private:
+        const char* m_name;
+        int m_modes;
+        std::chrono::steady_clock::time_point m_start;
+
+    public:
+        explicit CpuScope(const char* name) : m_name(name), m_modes(activeModes()) {
+            if (m_modes) m_start = std::chrono::steady_clock::now();
+        }
+        ~CpuScope() {
+            if (!m_modes) return;
+            const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+            if (m_modes & ModeOverlay) {
+                recordSample(m_name, Source::Cpu, std::chrono::duration<double, std::milli>(end - m_start).count());
+            }
+            if (m_modes & ModeTrace) {
+                recordTraceEvent(m_name, m_start, end);
+            }
+        }
+
+        CpuScope(const CpuScope&) = delete;
+        CpuScope& operator=(const CpuScope&) = delete;
+    };
+
+} // namespace Profiler
+
+#define PROFILER_CONCAT_IMPL(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_IMPL(a, b)
+
+#ifdef AUCAD_NO_PROFILER
+#define PROFILE_SCOPE(name) do {} while (0)
+#else
+#define PROFILE_SCOPE(name) Profiler::CpuScope PROFILER_CONCAT(profileScope_, __LINE__)(name)
+#endif
+
+#endif // PROFILER_HPP
@@ -0,0 +1,254 @@
+#include "TaskScheduler.hpp"
+#include "Profiler.hpp"
+
+namespace {
+    // Which pool the current thread works for, and its queue in that pool
+    thread_local TaskScheduler* t_scheduler = nullptr;
+    thread_local int t_workerIndex = -1;
+}
+
+// TaskScheduler ======================================================================================
+TaskScheduler::TaskScheduler(int workerCount)
+    : m_queued(0), m_stop(false), m_workerCount(0), m_waiting(0)
+{
+    for (int i = 0; i <= kMaxWorkers; ++i) {
+        m_queues.emplace_back(new TaskQueue());
+    }
+    setWorkerCount(workerCount);
+}
+
+TaskScheduler::~TaskScheduler() {
+    std::lock_guard<std::mutex> lock(m_configMutex);
+    stopWorkers();
+}
+
+TaskScheduler& TaskScheduler::instance() {
+    static TaskScheduler scheduler;
+    return scheduler;
+}
+
+int TaskScheduler::defaultWorkerCount() {
+    unsigned int count = std::thread::hardware_concurrency();
+    return count <= 1 ? 1 : static_cast<int>(count) - 1;
+}
+
+void TaskScheduler::setWorkerCount(int count) {
+    if (count <= 0) count = defaultWorkerCount();
+    count = std::min(count, kMaxWorkers);
+
+    std::lock_guard<std::mutex> lock(m_configMutex);
+    if (count == m_workerCount) return;
+
+    // Tasks left in the queues of stopped workers are stolen by the new ones
+    stopWorkers();
+    m_stop = false;
+    for (int i = 0; i < count; ++i) {
+        m_threads.emplace_back(&TaskScheduler::workerLoop, this, i);
+    }
+    m_workerCount = count;
+}
+
+void TaskScheduler::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+    m_threads.clear();
+    m_workerCount = 0;
+}
+
+void TaskScheduler::push(Task task) {
+    const int index = (t_scheduler == this && t_workerIndex >= 0) ? t_workerIndex : kMaxWorkers;
+    TaskQueue& queue = *m_queues[index];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+        queue.size++;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_queued++;
+    }
+    m_wake.notify_one();
+    notifyWaiters();
+}
+
+void TaskScheduler::notifyWaiters() {
+    if (m_waiting == 0) return;
+
+    // Taking the mutex orders this after a waiter's predicate check, so the wakeup can't fall in between
+    { std::lock_guard<std::mutex> lock(m_doneMutex); }
+    m_done.notify_all();
+}
+
+bool TaskScheduler::tryRunOne() {
+    Task task;
+    const int self = (t_scheduler == this) ? t_workerIndex : -1;
+
+    // Own queue first, newest task, it is the one most likely still in cache
+    if (self >= 0 && m_queues[self]->size > 0) {
+        TaskQueue& queue = *m_queues[self];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            queue.size--;
+        }
+    }
+
+    // Otherwise steal the oldest task of someone else, starting after ourselves to spread the thieves
+    for (int i = 1; !task && i <= kMaxWorkers + 1; ++i) {
+        const int victim = (self + i + kMaxWorkers + 1) % (kMaxWorkers + 1);
+        TaskQueue& queue = *m_queues[victim];
+        if (queue.size == 0) continue;
+
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            queue.size--;
+        }
+    }
+
+    if (!task) return false;
+
+    m_queued--;
+    task();
+    notifyWaiters();
+    return true;
+}
+
+void TaskScheduler::workerLoop(int index) {
+    t_scheduler = this;
+    t_workerIndex = index;
+    Profiler::setThreadName("worker " + std::to_string(index));
+
+    while (true) {
+        if (m_stop) return;
+        if (tryRunOne()) continue;
+
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        m_wake.wait(lock, [this]() { return m_stop || m_queued > 0; });
+    }
+}
+
+void TaskScheduler::schedule(Task task, const char* name) {
+    if (!name) {
+        push(std::move(task));
+        return;
+    }
+
+    std::string taskName(name);
+    push([this, task, taskName]() {
+        const auto start = std::chrono::steady_clock::now();
+        task();
+        recordTiming(taskName.c_str(), std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    });
+}
+
+void TaskScheduler::helpUntil(const std::function<bool()>& done) {
+    while (!done()) {
+        if (tryRunOne()) continue;
+
+        // Nothing to steal, the remaining work runs elsewhere. Sleep instead of spinning a core on it.
+        std::unique_lock<std::mutex> lock(m_doneMutex);
+        m_waiting++;
+        m_done.wait(lock, [this, &done]() { return done() || m_queued > 0; });
+        m_waiting--;
+    }
+}
+
+void TaskScheduler::runOnMainThread(Task task) {
+    std::function<void()> wake;
+    {
+        std::lock_guard<std::mutex> lock(m_mainMutex);
+        m_mainTasks.push_back(std::move(task));
+        wake = m_mainWakeCallback;
+    }
+    if (wake) {
+        wake();
+    }
+}
+
+int TaskScheduler::pumpMainThread() {
+    std::vector<Task> tasks;
+    {
+        std::lock_guard<std::mutex> lock(m_mainMutex);
+        tasks.swap(m_mainTasks);
+    }
+    for (Task& task : tasks) {
+        task();
+    }
+    return static_cast<int>(tasks.size());
+}
+
+void TaskScheduler::setMainThreadWakeCallback(const std::function<void()>& callback) {
+    std::lock_guard<std::mutex> lock(m_mainMutex);
+    m_mainWakeCallback = callback;
+}
+
+void TaskScheduler::recordTiming(const char* name, double ms) {
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    TaskStats& stats = m_stats[name];
+    stats.count++;
+    stats.totalMs += ms;
+    stats.maxMs = std::max(stats.maxMs, ms);
+}
+
+std::map<std::string, TaskScheduler::TaskStats> TaskScheduler::getStats() const {
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    return m_stats;
+}
+
+void TaskScheduler::resetStats() {
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    m_stats.clear();
+}
+
+// TaskGraph ======================================================================================
+int TaskGraph::add(const std::string& name, const std::function<void()>& fn) {
+    m_nodes.emplace_back();
+    m_nodes.back().name = name;
+    m_nodes.back().fn = fn;
+    return static_cast<int>(m_nodes.size()) - 1;
+}
+
+void TaskGraph::precede(int before, int after) {
+    m_nodes[before].successors.push_back(after);
+    m_nodes[after].dependencies++;
+}
+
+void TaskGraph::launch(TaskScheduler& scheduler, int index, std::atomic<int>& remaining) {
+    scheduler.schedule([this, &scheduler, &remaining, index]() {
+        Node& node = m_nodes[index];
+        node.fn();
+        for (int successor : node.successors) {
+            if (--m_nodes[successor].pending == 0) {
+                launch(scheduler, successor, remaining);
+            }
+        }
+        remaining--;
+    }, m_nodes[index].name.c_str());
+}
+
+void TaskGraph::run(TaskScheduler& scheduler) {
+    if (m_nodes.empty()) return;
+
+    std::atomic<int> remaining(static_cast<int>(m_nodes.size()));
+    for (Node& node : m_nodes) {
+        node.pending = node.dependencies;
+    }
+    for (int i = 0; i < static_cast<int>(m_nodes.size()); ++i) {
+        if (m_nodes[i].dependencies == 0) {
+            launch(scheduler, i, remaining);
+        }
+    }
+
+    scheduler.helpUntil([&remaining]() { return remaining == 0; });
+}
@@ -0,0 +1,179 @@
+#ifndef TASK_SCHEDULER_HPP
+#define TASK_SCHEDULER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Project-wide CPU task system.
+// Every worker owns a deque: it pushes and pops at the back, idle workers steal from the front of the others.
+// Threads that wait on tasks (parallelFor, TaskGraph::run) execute queued tasks meanwhile instead of blocking,
+// so nested parallel loops never deadlock. Long blocking I/O does not belong here, see GenAPI::GenerationQueue.
+// setWorkerCount must not be called from inside a task.
+class TaskScheduler {
+public:
+    typedef std::function<void()> Task;
+
+    struct TaskStats {
+        int count = 0;
+        double totalMs = 0.0;
+        double maxMs = 0.0;
+    };
+
+    static const int kMaxWorkers = 64;
+
+private:
+    struct TaskQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::atomic<int> size{0};
+    };
+
+    // kMaxWorkers worker queues plus one injection queue for threads outside the pool.
+    // Fixed for the scheduler's lifetime, so resizing the pool never moves a queue under a running thread.
+    std::vector<std::unique_ptr<TaskQueue>> m_queues;
+    std::vector<std::thread> m_threads;
+    std::mutex m_configMutex;
+
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+    std::atomic<int> m_queued;
+    std::atomic<bool> m_stop;
+    std::atomic<int> m_workerCount;
+
+    // helpUntil sleeps here when there is nothing to steal, woken by every finished or newly queued task
+    std::mutex m_doneMutex;
+    std::condition_variable m_done;
+    std::atomic<int> m_waiting;
+
+    std::mutex m_mainMutex;
+    std::vector<Task> m_mainTasks;
+    std::function<void()> m_mainWakeCallback;
+
+    mutable std::mutex m_statsMutex;
+    std::map<std::string, TaskStats> m_stats;
+
+    void workerLoop(int index);
+    void stopWorkers();
+    void push(Task task);
+    bool tryRunOne();
+    void notifyWaiters();
+
+public:
+    explicit TaskScheduler(int workerCount = 0);
+    ~TaskScheduler();
+
+    static TaskScheduler& instance();
+    static int defaultWorkerCount(); // One less than the hardware threads, the caller always helps
+
+    // Restarts the pool, tasks already queued are kept
+    void setWorkerCount(int count);
+    int getWorkerCount() const { return m_workerCount; }
+
+    void schedule(Task task, const char* name = nullptr);
+
+    // Executes queued tasks on the calling thread until done() holds, sleeps while there are none to take.
+    // done() must only change through a task of this scheduler, that is what wakes the caller.
+    void helpUntil(const std::function<bool()>& done);
+
+    // fn(chunkBegin, chunkEnd) over [begin, end), chunks hold at least grain items.
+    // The calling thread takes part and returns once every chunk finished.
+    template <typename Func>
+    void parallelFor(int begin, int end, Func fn, int grain = 1, const char* name = nullptr) {
+        const int count = end - begin;
+        if (count <= 0) return;
+
+        const auto start = std::chrono::steady_clock::now();
+
+        // A few chunks per thread so stealing can even out uneven chunks
+        const int maxChunks = (getWorkerCount() + 1) * 4;
+        const int chunks = std::max(1, std::min(maxChunks, count / std::max(1, grain)));
+        if (chunks == 1) {
+            fn(begin, end);
+        }
+        else {
+            const int chunkSize = (count + chunks - 1) / chunks;
+            std::atomic<int> remaining(0);
+            for (int chunkBegin = begin + chunkSize; chunkBegin < end; chunkBegin += chunkSize) {
+                const int chunkEnd = std::min(end, chunkBegin + chunkSize);
+                remaining++;
+                push([&fn, &remaining, chunkBegin, chunkEnd]() {
+                    fn(chunkBegin, chunkEnd);
+                    remaining--;
+                });
+            }
+
+            fn(begin, std::min(end, begin + chunkSize));
+            helpUntil([&remaining]() { return remaining == 0; });
+        }
+
+        if (name) {
+            recordTiming(name, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+    }
+
+    // Runs fn on a worker, the future becomes ready when it returns.
+    // Wait for it through helpUntil rather than get(), so the waiting thread keeps working on the pool.
+    template <typename Func>
+    auto async(const char* name, Func fn) -> std::future<decltype(fn())> {
+        typedef decltype(fn()) Result;
+        auto task = std::make_shared<std::packaged_task<Result()>>(fn);
+        std::future<Result> future = task->get_future();
+        schedule([task]() { (*task)(); }, name);
+        return future;
+    }
+
+    // Runs work on a worker and hands its result to done on the main thread, see pumpMainThread
+    template <typename Work, typename Done>
+    void asyncThenMain(const char* name, Work work, Done done) {
+        schedule([this, work, done]() {
+            auto result = work();
+            runOnMainThread([done, result]() { done(result); });
+        }, name);
+    }
+
+    // Main thread continuations, executed by whoever calls pumpMainThread (Engine, once per frame)
+    void runOnMainThread(Task task);
+    int pumpMainThread();
+    void setMainThreadWakeCallback(const std::function<void()>& callback);
+
+    // Per-name wall time, parallelFor records the whole loop, scheduled tasks each run
+    void recordTiming(const char* name, double ms);
+    std::map<std::string, TaskStats> getStats() const;
+    void resetStats();
+};
+
+// Tasks with dependencies, run to completion by run()
+class TaskGraph {
+private:
+    struct Node {
+        std::string name;
+        std::function<void()> fn;
+        std::vector<int> successors;
+        int dependencies = 0;
+        std::atomic<int> pending{0};
+    };
+
+    std::deque<Node> m_nodes; // deque, nodes hold atomics and must not move
+
+    void launch(TaskScheduler& scheduler, int index, std::atomic<int>& remaining);
+
+public:
+    int add(const std::string& name, const std::function<void()>& fn);
+    void precede(int before, int after);
+
+    // Blocks until every node ran, the calling thread executes tasks meanwhile
+    void run(TaskScheduler& scheduler = TaskScheduler::instance());
+};
+
+#endif // TASK_SCHEDULER_HPP
@@ -1,4 +1,5 @@
 #include "Axis.hpp"
+#include "../Utilities/Logger.hpp"
 
 Object::Axis::Axis(Shader* shader, float radius, float radius_scale, float scale, float offset, int segments) : Base(shader) {
     std::vector<float> vertices;
@@ -142,8 +143,8 @@ void Object::Axis::draw(const CameraParam& cameraParam) {
     // Call this right after the block you want to check
     GLenum err;
     while ((err = glGetError()) != GL_NO_ERROR) {
-        std::cerr << "[OpenGL][] Error 0x"
+        LOG_ERROR("[OpenGL][] Error 0x"
                   << std::hex << err << std::dec
-                  << ": " << GetGLErrorString(err) << "\n";
+                  << ": " << GetGLErrorString(err));
     }
 }
@@ -1,6 +1,7 @@
 #include "BaseObject.hpp"
 
 Object::Base::Base(Shader* shader)
+    : VAO(0), VBO(0), EBO(0), bufferSize(0), indicesSize(0)
 {
     this->shader = shader;
     reset();
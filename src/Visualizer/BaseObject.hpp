@@ -42,6 +42,8 @@ namespace Object {
         void scale(const Eigen::Vector3f& scale);
 
         GLuint getVBO() { return VBO; }
+        size_t getVBOBytes() const { return VBO ? bufferSize * sizeof(float) : 0; }
+        size_t getEBOBytes() const { return EBO ? indicesSize * sizeof(unsigned int) : 0; }
     };
 }
 
@@ -1,18 +1,20 @@
 #include "Mesh.hpp"
+#include "../Utilities/Logger.hpp"
 
 
 Object::Mesh::Mesh(Shader* shader,
                    const std::vector<Eigen::Vector3f>& vertices,
                    const std::vector<Eigen::Vector3f>& normals,
                    const std::vector<Eigen::Vector3i>& indices)
-    : Base(shader) {
+    : Base(shader), m_colormapTexture(0), m_visMode(0), m_scalarRange(0.08f),
+      m_skinVBO(0), m_handleBuffer(0), m_handleTexture(0), m_skinBytes(0), m_handleBytes(0), m_skinning(false) {
 
     if (vertices.size() != normals.size()) {
-        std::cout << "Vertices and Normals doesn't match\n";
+        LOG_WARN("Vertices and Normals doesn't match");
     }
 
     std::vector<float> buffer;
-    std::vector<float> bufferPositions, bufferNormals, bufferColors;
+    std::vector<float> bufferPositions, bufferNormals, bufferColors, bufferScalars;
 
     for (const auto& tri : indices) {
         for (int j = 0; j < 3; ++j) {
@@ -31,6 +33,9 @@ Object::Mesh::Mesh(Shader* shader,
             bufferColors.push_back(0.0f);
             bufferColors.push_back(0.0f);
             bufferColors.push_back(0.0f);
+            bufferColors.push_back(0.0f); // Selected flag
+
+            bufferScalars.push_back(0.0f);
         }
     }
 
@@ -38,6 +43,7 @@ Object::Mesh::Mesh(Shader* shader,
     buffer.insert(buffer.end(), bufferPositions.begin(), bufferPositions.end());
     buffer.insert(buffer.end(), bufferNormals.begin(), bufferNormals.end());
     buffer.insert(buffer.end(), bufferColors.begin(), bufferColors.end());
+    buffer.insert(buffer.end(), bufferScalars.begin(), bufferScalars.end());
 
     // INDICES ONLY FOR WIREFRAME SETUP!!!
     std::vector<unsigned int> bufferIndices;
@@ -51,9 +57,15 @@ Object::Mesh::Mesh(Shader* shader,
     indicesSize = 0;
 
     init(buffer, bufferIndices);
+    initColormap();
 }
 
-Object::Mesh::~Mesh() {}
+Object::Mesh::~Mesh() {
+    if (m_colormapTexture) glDeleteTextures(1, &m_colormapTexture);
+    if (m_skinVBO) glDeleteBuffers(1, &m_skinVBO);
+    if (m_handleBuffer) glDeleteBuffers(1, &m_handleBuffer);
+    if (m_handleTexture) glDeleteTextures(1, &m_handleTexture);
+}
 
 void Object::Mesh::init(std::vector<float>& buffer, std::vector<unsigned int>& indices) {
     glGenVertexArrays(1, &VAO);
@@ -64,19 +76,95 @@ void Object::Mesh::init(std::vector<float>& buffer, std::vector<unsigned int>& i
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, buffer.size() * sizeof(float), buffer.data(), GL_STATIC_DRAW);
 
-    size_t vertexCount = buffer.size() / 9;
+    // Data of Mesh: [ X Y Z ] [ NX NY NZ ] [ R G B SEL ] [ S ]
+    size_t vertexCount = buffer.size() / 11;
     size_t verticesOffset = 0;
     size_t normalsOffset = vertexCount * 3 * sizeof(float);
     size_t colorsOffset  = vertexCount * 6 * sizeof(float);
+    size_t scalarsOffset = vertexCount * 10 * sizeof(float);
 
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)verticesOffset);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, (void*)normalsOffset);
     glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, (void*)colorsOffset);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, 0, (void*)colorsOffset);
     glEnableVertexAttribArray(2);
+    glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, 0, (void*)scalarsOffset);
+    glEnableVertexAttribArray(3);
+
+    glBindVertexArray(0);
+}
+
+void Object::Mesh::setSkinWeights(const std::vector<float>& bindPositions, const std::vector<int>& indices,
+                                  const std::vector<float>& weights) {
+    // Data of Skin: [ X Y Z ] [ I0 I1 I2 I3 ] [ W0 W1 W2 W3 ], one entry per corner like the mesh VBO
+    size_t positionsBytes = bindPositions.size() * sizeof(float);
+    size_t indicesBytes = indices.size() * sizeof(int);
+    size_t weightsBytes = weights.size() * sizeof(float);
+    m_skinBytes = positionsBytes + indicesBytes + weightsBytes;
+
+    if (!m_skinVBO) glGenBuffers(1, &m_skinVBO);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, m_skinVBO);
+    glBufferData(GL_ARRAY_BUFFER, m_skinBytes, nullptr, GL_STATIC_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, positionsBytes, bindPositions.data());
+    glBufferSubData(GL_ARRAY_BUFFER, positionsBytes, indicesBytes, indices.data());
+    glBufferSubData(GL_ARRAY_BUFFER, positionsBytes + indicesBytes, weightsBytes, weights.data());
+
+    glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+    glEnableVertexAttribArray(4);
+    glVertexAttribIPointer(5, 4, GL_INT, 0, (void*)positionsBytes);
+    glEnableVertexAttribArray(5);
+    glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, 0, (void*)(positionsBytes + indicesBytes));
+    glEnableVertexAttribArray(6);
 
     glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Object::Mesh::setHandleOffsets(const std::vector<float>& offsets) {
+    // A few floats per handle, the whole buffer is respecified every time
+    if (!m_handleBuffer) {
+        glGenBuffers(1, &m_handleBuffer);
+        glGenTextures(1, &m_handleTexture);
+    }
+    m_handleBytes = offsets.size() * sizeof(float);
+
+    glBindBuffer(GL_TEXTURE_BUFFER, m_handleBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, m_handleBytes, offsets.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glBindTexture(GL_TEXTURE_BUFFER, m_handleTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_handleBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void Object::Mesh::initColormap() {
+    // Diverging blue -> white -> red ramp, sampled with t = scalar / range * 0.5 + 0.5
+    const int size = 256;
+    std::vector<float> texels(size * 3);
+    for (int i = 0; i < size; ++i) {
+        float t = 2.0f * i / (size - 1) - 1.0f; // [-1, 1]
+        if (t < 0.0f) {
+            // Concave (blue to white)
+            texels[i * 3 + 0] = 1.0f + t;
+            texels[i * 3 + 1] = 1.0f + t;
+            texels[i * 3 + 2] = 1.0f;
+        } else {
+            // Convex (white to red)
+            texels[i * 3 + 0] = 1.0f;
+            texels[i * 3 + 1] = 1.0f - t;
+            texels[i * 3 + 2] = 1.0f - t;
+        }
+    }
+
+    glGenTextures(1, &m_colormapTexture);
+    glBindTexture(GL_TEXTURE_1D, m_colormapTexture);
+    glTexImage1D(GL_TEXTURE_1D, 0, GL_RGB32F, size, 0, GL_RGB, GL_FLOAT, texels.data());
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_1D, 0);
 }
 
 
@@ -86,7 +174,19 @@ void Object::Mesh::draw(const CameraParam& cameraParam) {
     shader->setMat4("view", cameraParam.view);
     shader->setVec3("camPos", cameraParam.position);
     shader->setMat4("model", modelMatrix);
+    shader->setInt("visMode", m_visMode);
+    shader->setFloat("scalarRange", m_scalarRange);
+    shader->setInt("colormap", 0);
+    shader->setBool("skinning", m_skinning);
+    shader->setInt("handleOffsets", 1);
+
+    if (m_skinning) {
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_BUFFER, m_handleTexture);
+    }
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_1D, m_colormapTexture);
 
     glBindVertexArray(VAO);
-    glDrawArrays(GL_TRIANGLES, 0, bufferSize / 9);
+    glDrawArrays(GL_TRIANGLES, 0, bufferSize / 11);
 }
@@ -6,6 +6,18 @@
 namespace Object {
     class Mesh : public Base {
     private:
+        // Scalar field colormapping happens in the shader, these are just uniforms
+        GLuint m_colormapTexture;
+        int m_visMode;
+        float m_scalarRange;
+
+        // Linear blend skinning preview, positions come from the bind pose blended by the handle offsets
+        GLuint m_skinVBO;           // Per corner: [ X Y Z ] [ I0 I1 I2 I3 ] [ W0 W1 W2 W3 ]
+        GLuint m_handleBuffer, m_handleTexture; // Texture buffer of one xyzw offset per handle
+        size_t m_skinBytes, m_handleBytes;
+        bool m_skinning;
+
+        void initColormap();
 
     public:
         Mesh(Shader* shader,
@@ -17,6 +29,17 @@ namespace Object {
         void init(std::vector<float>& buffer, std::vector<unsigned int>& indices) override;
         void draw(const CameraParam& cameraParam) override;
 
+        void setVisMode(int mode) { m_visMode = mode; }
+        void setScalarRange(float range) { m_scalarRange = range; }
+
+        void setSkinWeights(const std::vector<float>& bindPositions, const std::vector<int>& indices,
+                            const std::vector<float>& weights); // Per corner, 4 influences each
+        void setHandleOffsets(const std::vector<float>& offsets);
+        void setSkinning(bool enabled) { m_skinning = enabled && m_skinVBO != 0 && m_handleTexture != 0; }
+        bool isSkinning() const { return m_skinning; }
+        size_t getSkinBytes() const { return m_skinBytes; }
+        size_t getHandleBytes() const { return m_handleBytes; }
+
         static std::vector<Mesh*> loadMeshes(Shader* shader, Shader* wireframe_shader, const std::string& filePath);
     };
 }
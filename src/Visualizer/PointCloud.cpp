@@ -97,6 +97,8 @@ void Object::PointCloud::draw(const CameraParam& cameraParam)
     shader->use();
     shader->setMat4("projection", cameraParam.projection);
     shader->setMat4("view", cameraParam.view);
+    shader->setInt("visMode", 0); // Shares the mesh shader, always draw with the vertex color
+    shader->setBool("skinning", false);
     glBindVertexArray(VAO);
 
 
@@ -115,6 +117,8 @@ void Object::PointCloud::draw(const CameraParam& cameraParam, const std::vector<
     shader->use();
     shader->setMat4("projection", cameraParam.projection);
     shader->setMat4("view", cameraParam.view);
+    shader->setInt("visMode", 0);
+    shader->setBool("skinning", false);
     glBindVertexArray(VAO);
 
     for(int i = 0; i < m_offsets.size(); i++) {
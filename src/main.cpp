@@ -1,15 +1,78 @@
 #define STB_IMAGE_IMPLEMENTATION
 
 #include "Engine.hpp"
+#include "Utilities/Logger.hpp"
+
+#include <cstdlib>
+#include <cstdio>
+#include <iostream>
+
+namespace {
+    void printUsage(const char* program) {
+        std::cout << "Usage: " << program << " [--offscreen [options]] [--record <file> | --replay <file> [options]] [--trace <file>]\n"
+                  << "  --offscreen          Render into an FBO of an invisible window and report frame times\n"
+                  << "  --frames <n>         Measured frames (default 600)\n"
+                  << "  --warmup <n>         Frames drawn before measuring (default 30)\n"
+                  << "  --size <w>x<h>       Framebuffer size (default 1280x720)\n"
+                  << "  --camera <path>      orbit, zoom or orbit-zoom (default orbit)\n"
+                  << "  --no-ui              Leave the ImGui interface out of the frame\n"
+                  << "  --pose-updates       Re-upload the pose every frame\n"
+                  << "  --json <file>        Write the report here instead of stdout\n"
+                  << "  --record <file>      Log every input event and frame of this run\n"
+                  << "  --replay <file>      Play a recorded session back and report frame times\n"
+                  << "  --replay-fast        Draw replayed frames back to back instead of at the recorded pace\n"
+                  << "  --replay-nosync      Don't wait for background work before each replayed frame\n"
+                  << "  --trace <file>       Write a Chrome trace of the whole run\n"
+                  << "  --log-level <level>  trace, debug, info, warn, error or off (default info)\n";
+    }
+
+    bool parseArgs(int argc, char** argv, OffscreenOptions& options, SessionOptions& session) {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+
+            if (arg == "--offscreen") options.enabled = true;
+            else if (arg == "--frames" && hasValue) options.frames = std::atoi(argv[++i]);
+            else if (arg == "--warmup" && hasValue) options.warmupFrames = std::atoi(argv[++i]);
+            else if (arg == "--size" && hasValue) {
+                if (sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2) return false;
+            }
+            else if (arg == "--camera" && hasValue) options.cameraPath = argv[++i];
+            else if (arg == "--no-ui") options.drawInterface = false;
+            else if (arg == "--pose-updates") options.poseUpdates = true;
+            else if (arg == "--json" && hasValue) options.jsonOut = argv[++i];
+            else if (arg == "--record" && hasValue) session.recordPath = argv[++i];
+            else if (arg == "--replay" && hasValue) session.replayPath = argv[++i];
+            else if (arg == "--replay-fast") session.replayFast = true;
+            else if (arg == "--replay-nosync") session.replaySync = false;
+            else if (arg == "--trace" && hasValue) session.tracePath = argv[++i];
+            else if (arg == "--log-level" && hasValue) {
+                Logger::Level level;
+                if (!Logger::parseLevel(argv[++i], level)) return false;
+                Logger::setLevel(level);
+            }
+            else return false;
+        }
+        if (!session.recordPath.empty() && !session.replayPath.empty()) return false;
+        const bool knownPath = options.cameraPath == "orbit" || options.cameraPath == "zoom" || options.cameraPath == "orbit-zoom";
+        return knownPath && options.width > 0 && options.height > 0 && options.frames > 0;
+    }
+}
 
 int main(int argc, char** argv) {
+    OffscreenOptions offscreen;
+    SessionOptions session;
+    if (!parseArgs(argc, argv, offscreen, session)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
 #ifdef _OPENMP
-    std::cout << "OpenMP is available! Version: " << _OPENMP << std::endl;
+    LOG_INFO("OpenMP is available! Version: " << _OPENMP);
 #else
-    std::cout << "OpenMP is NOT available!" << std::endl;
+    LOG_INFO("OpenMP is NOT available!");
 #endif
 
-    Engine engine;
-    engine.run();
-    return 0;
+    Engine engine(offscreen, session);
+    return engine.run();
 }